@@ -0,0 +1,133 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o adaptive_mutex_benchmark
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o adaptive_mutex_benchmark
+
+// AdaptiveMutex vs std::mutex vs a test and test and set spinlock on a short critical section
+// - every thread locks, bumps a few shared counters, unlocks, then does a little private work
+// - thread counts double up to the effective cpu count, then 2x and 4x oversubscribed
+//   (threads pinned round robin over the effective cpus so the oversubscribed runs share cpus)
+// - reports lock acquisitions per second, context switches and the adaptive spin budget at the end
+// $ ./adaptive_mutex_benchmark [milliseconds per run]
+
+#include "AdaptiveMutex.h"
+#include "CpuTopology.h"
+#include "Futex.h"
+#include "LinuxThread.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <sys/resource.h>
+#include <vector>
+
+
+class SpinLock
+{
+
+public:
+
+    void lock()
+    {
+        while (true) {
+            if (!locked_.exchange(true, std::memory_order_acquire)) return;
+            while (locked_.load(std::memory_order_relaxed)) CpuRelax();
+        }
+    }
+
+    void unlock()
+    {
+        locked_.store(false, std::memory_order_release);
+    }
+
+private:
+
+    alignas(kCacheLineSize) std::atomic<bool> locked_{false};
+};
+
+
+// data guarded by the lock, on its own line
+struct alignas(kCacheLineSize) Shared
+{
+    uint64_t counter;
+    uint64_t checksum;
+};
+
+
+long context_switches()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+
+template <typename Lock>
+void run(const char* name, Lock& lock, unsigned int num_threads, std::chrono::milliseconds duration)
+{
+    Shared shared{0, 0};
+    std::atomic<bool> stop{false};
+    std::vector<uint64_t> acquisitions(num_threads);
+
+    long switches_start = context_switches();
+    {
+        std::vector<std::unique_ptr<LinuxThread>> threads;
+        for (unsigned int idx = 0; idx < num_threads; idx++) {
+            threads.push_back(std::make_unique<LinuxThread>([&, idx]() {
+                uint64_t count{0};
+                uint64_t local{idx};
+                while (!stop.load(std::memory_order_relaxed)) {
+                    {
+                        std::lock_guard<Lock> lck (lock);
+                        shared.counter++;
+                        shared.checksum += local;
+                    }
+                    count++;
+                    // private work between critical sections
+                    for (int i = 0; i < 32; i++) local = local * 6364136223846793005ULL + 1;
+                }
+                acquisitions[idx] = count;
+            }, CpuTopology::EffectiveCpu(idx)));
+        }
+        std::this_thread::sleep_for(duration);
+        stop = true;
+    }
+    long switches = context_switches() - switches_start;
+
+    uint64_t total{0};
+    for (uint64_t count : acquisitions) total += count;
+
+    std::printf("%8u %-14s %14.0f %12ld%s\n", num_threads, name, total / std::chrono::duration<double>(duration).count(),
+        switches, (total == shared.counter) ? "" : "  LOST UPDATES");
+}
+
+
+int main(int argc, char* argv[])
+{
+    std::chrono::milliseconds duration((argc > 1) ? std::atoi(argv[1]) : 500);
+    unsigned int cpus = CpuTopology::EffectiveConcurrency();
+
+    std::vector<unsigned int> thread_counts;
+    for (unsigned int num_threads = 1; num_threads < cpus; num_threads *= 2) thread_counts.push_back(num_threads);
+    thread_counts.push_back(cpus);
+    thread_counts.push_back(2 * cpus);
+    thread_counts.push_back(4 * cpus);
+
+    AdaptiveMutex adaptive;
+    std::mutex mutex;
+    SpinLock spin;
+
+    std::printf("%u effective cpus, %ld ms per run\n", cpus, static_cast<long>(duration.count()));
+    std::printf("%8s %-14s %14s %12s\n", "threads", "lock", "locks/sec", "ctx switches");
+    for (unsigned int num_threads : thread_counts) {
+        run("std::mutex", mutex, num_threads, duration);
+        run("spinlock", spin, num_threads, duration);
+        run("AdaptiveMutex", adaptive, num_threads, duration);
+        std::printf("%8s %-14s spin limit %u\n", "", "", adaptive.SpinLimit());
+    }
+
+    return 0;
+}
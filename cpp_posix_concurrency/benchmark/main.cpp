@@ -0,0 +1,288 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o benchmark
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o benchmark
+
+// microbenchmarks of the cpp_posix_concurrency primitives, machine readable so builds can be compared
+// - linux_thread : create + join under each LinuxThread constructor
+// - linux_thread_move : move construction and move assignment of a LinuxThread
+// - round_trip : std::async vs std::packaged_task vs raw std::thread running a trivial function
+// - promise_future : set/get on one thread and a ping pong between two threads
+// - sync_log : SyncLog::Log() throughput by logging thread count
+// - each operation is timed on its own, results give mean / p50 / p99 ns and ops/sec
+// - stdout of the primitives (SyncLog) goes to /dev/null, results go to the original stdout or -o
+// $ ./benchmark [-f csv|json] [-n iterations] [-o results_file]
+
+#include "LinuxThread.h"
+#include "SyncLog.h"
+#include "ThreadAttributes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <future>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+
+struct Result
+{
+    std::string group;
+    std::string name;
+    unsigned int threads;
+    std::size_t iterations;
+    double mean_ns;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    double ops_per_sec;
+};
+
+
+static std::vector<Result> results;
+
+
+uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+void record(const std::string& group, const std::string& name, unsigned int threads, std::vector<uint64_t> samples, double elapsed_ns)
+{
+    std::sort(samples.begin(), samples.end());
+    double sum{0};
+    for (uint64_t sample : samples) sum += sample;
+
+    results.push_back({group, name, threads, samples.size(), sum / samples.size(),
+        samples[samples.size() / 2], samples[samples.size() * 99 / 100], samples.size() * 1e9 / elapsed_ns});
+}
+
+
+// time every call of op on its own
+void measure(const std::string& group, const std::string& name, std::size_t iterations, const std::function<void()>& op)
+{
+    std::vector<uint64_t> samples(iterations);
+    uint64_t start = now_ns();
+    for (std::size_t i = 0; i < iterations; i++) {
+        uint64_t before = now_ns();
+        op();
+        samples[i] = now_ns() - before;
+    }
+    record(group, name, 1, std::move(samples), now_ns() - start);
+}
+
+
+void bench_linux_thread(std::size_t iterations)
+{
+    cpu_set_t cpus = LinuxThread::CpuSet(0);
+    ThreadAttributes attributes = ThreadAttributes().Affinity(0u);
+
+    measure("linux_thread", "func", iterations, []() {
+        LinuxThread thread([]() {});
+    });
+    measure("linux_thread", "func_affinity", iterations, []() {
+        LinuxThread thread([]() {}, 0u);
+    });
+    measure("linux_thread", "func_cpu_set", iterations, [&cpus]() {
+        LinuxThread thread([]() {}, cpus);
+    });
+    measure("linux_thread", "func_attributes", iterations, [&attributes]() {
+        LinuxThread thread([]() {}, attributes);
+    });
+    measure("linux_thread", "named_affinity", iterations, []() {
+        LinuxThread thread([](std::string) {}, "bench", 0u);
+    });
+    measure("linux_thread", "named_cpu_set", iterations, [&cpus]() {
+        LinuxThread thread([](std::string) {}, "bench", cpus);
+    });
+    measure("linux_thread", "named_attributes", iterations, [&attributes]() {
+        LinuxThread thread([](std::string) {}, "bench", attributes);
+    });
+    measure("linux_thread", "policy_priority_affinity", iterations, []() {
+        LinuxThread thread([](std::string, int, int) {}, "bench", SCHED_OTHER, 0, 0u);
+    });
+    measure("linux_thread", "policy_priority_cpu_set", iterations, [&cpus]() {
+        LinuxThread thread([](std::string, int, int) {}, "bench", SCHED_OTHER, 0, cpus);
+    });
+}
+
+
+void bench_linux_thread_move(std::size_t iterations)
+{
+    // a finished thread, moves only transfer ownership of the handle
+    LinuxThread a([]() {});
+    LinuxThread b([]() {});
+    b.Join();
+
+    measure("linux_thread_move", "construct", iterations, [&a]() {
+        LinuxThread moved(std::move(a));
+        a = std::move(moved);
+    });
+    measure("linux_thread_move", "assign", iterations, [&a, &b]() {
+        b = std::move(a);
+        a = std::move(b);
+    });
+}
+
+
+int trivial()
+{
+    return 1;
+}
+
+
+void bench_round_trip(std::size_t iterations)
+{
+    measure("round_trip", "std_async", iterations, []() {
+        std::async(std::launch::async, trivial).get();
+    });
+    measure("round_trip", "packaged_task", iterations, []() {
+        std::packaged_task<int()> task(trivial);
+        std::future<int> future = task.get_future();
+        std::thread thread(std::move(task));
+        future.get();
+        thread.join();
+    });
+    measure("round_trip", "raw_thread", iterations, []() {
+        int value{0};
+        std::thread thread([&value]() { value = trivial(); });
+        thread.join();
+    });
+    measure("round_trip", "linux_thread", iterations, []() {
+        int value{0};
+        LinuxThread thread([&value]() { value = trivial(); });
+        thread.Join();
+    });
+}
+
+
+void bench_promise_future(std::size_t iterations)
+{
+    measure("promise_future", "set_get", iterations, []() {
+        std::promise<int> promise;
+        std::future<int> future = promise.get_future();
+        promise.set_value(1);
+        future.get();
+    });
+
+    // ping pong, the peer answers every request promise with a reply promise
+    std::vector<std::promise<int>> requests(iterations);
+    std::vector<std::promise<int>> replies(iterations);
+    std::thread peer([&]() {
+        for (std::size_t i = 0; i < iterations; i++) {
+            replies[i].set_value(requests[i].get_future().get());
+        }
+    });
+    std::size_t round{0};
+    measure("promise_future", "ping_pong", iterations, [&]() {
+        std::future<int> reply = replies[round].get_future();
+        requests[round++].set_value(1);
+        reply.get();
+    });
+    peer.join();
+}
+
+
+void bench_sync_log(std::size_t messages)
+{
+    unsigned int max_threads = std::max(2u, 2 * std::thread::hardware_concurrency());
+
+    for (unsigned int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        std::vector<std::vector<uint64_t>> latencies(num_threads, std::vector<uint64_t>(messages));
+        std::vector<std::thread> threads;
+
+        uint64_t start = now_ns();
+        for (unsigned int thread_idx = 0; thread_idx < num_threads; thread_idx++) {
+            threads.emplace_back([thread_idx, messages, &latencies]() {
+                for (std::size_t msg_idx = 0; msg_idx < messages; msg_idx++) {
+                    uint64_t before = now_ns();
+                    SyncLog::GetLog()->Log("thread " + std::to_string(thread_idx) + " message " + std::to_string(msg_idx));
+                    latencies[thread_idx][msg_idx] = now_ns() - before;
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        uint64_t elapsed_ns = now_ns() - start;
+
+        std::vector<uint64_t> all;
+        for (auto& thread_latencies : latencies) all.insert(all.end(), thread_latencies.begin(), thread_latencies.end());
+        record("sync_log", "log", num_threads, std::move(all), elapsed_ns);
+    }
+}
+
+
+void write_csv(FILE* out)
+{
+    std::fprintf(out, "group,name,threads,iterations,mean_ns,p50_ns,p99_ns,ops_per_sec\n");
+    for (auto& result : results) {
+        std::fprintf(out, "%s,%s,%u,%zu,%.1f,%lu,%lu,%.1f\n", result.group.c_str(), result.name.c_str(), result.threads,
+            result.iterations, result.mean_ns, result.p50_ns, result.p99_ns, result.ops_per_sec);
+    }
+}
+
+
+void write_json(FILE* out)
+{
+    std::fprintf(out, "{\n  \"compiler\": \"%s\",\n  \"cpus\": %u,\n  \"results\": [\n", __VERSION__, std::thread::hardware_concurrency());
+    for (std::size_t idx = 0; idx < results.size(); idx++) {
+        auto& result = results[idx];
+        std::fprintf(out, "    {\"group\": \"%s\", \"name\": \"%s\", \"threads\": %u, \"iterations\": %zu, "
+            "\"mean_ns\": %.1f, \"p50_ns\": %lu, \"p99_ns\": %lu, \"ops_per_sec\": %.1f}%s\n",
+            result.group.c_str(), result.name.c_str(), result.threads, result.iterations,
+            result.mean_ns, result.p50_ns, result.p99_ns, result.ops_per_sec, (idx + 1 < results.size()) ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+
+int main(int argc, char* argv[])
+{
+    bool json{false};
+    std::size_t iterations{2000};
+    const char* output{nullptr};
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:n:o:")) != -1) {
+        switch (opt) {
+        case 'f': json = (0 == std::strcmp(optarg, "json")); break;
+        case 'n': iterations = std::strtoul(optarg, nullptr, 10); break;
+        case 'o': output = optarg; break;
+        default:
+            std::fprintf(stderr, "usage: %s [-f csv|json] [-n iterations] [-o results_file]\n", argv[0]);
+            return 1;
+        }
+    }
+    // every result needs at least one sample
+    if (0 == iterations) {
+        std::fprintf(stderr, "usage: %s [-f csv|json] [-n iterations > 0] [-o results_file]\n", argv[0]);
+        return 1;
+    }
+
+    // results on the original stdout unless -o, primitive chatter to /dev/null
+    FILE* out = output ? std::fopen(output, "w") : fdopen(dup(STDOUT_FILENO), "w");
+    if (!out) {
+        std::fprintf(stderr, "failed to open %s\n", output);
+        return 1;
+    }
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+
+    bench_linux_thread(iterations);
+    bench_linux_thread_move(iterations * 10);
+    bench_round_trip(iterations);
+    bench_promise_future(iterations * 10);
+    bench_sync_log(iterations * 10);
+
+    if (json) write_json(out);
+    else write_csv(out);
+    std::fclose(out);
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o core_latency
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o core_latency
+
+// core to core latency matrix
+// - for every pair of cpus, two LinuxThreads pinned to them bounce one cache line back and forth,
+//   the cell is half the round trip time (best of the repeats)
+// - cpus are grouped into clusters by joining every pair below a threshold (default : the lower side of the
+//   largest relative gap between the measured latencies), a cluster is a set of cpus worth keeping a
+//   producer and its consumer in
+// - the last line is "clusters=<cpu list>;<cpu list>;..." for scripts, each list parses with CpuTopology::ParseCpuList
+// $ ./core_latency [-n round_trips] [-r repeats] [-c cpu_list] [-t threshold_ns]
+
+#include "CacheLine.h"
+#include "CpuTopology.h"
+#include "Futex.h"
+#include "LinuxThread.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+struct alignas(kCacheLineSize) PingPong
+{
+    std::atomic<uint64_t> sequence{0};
+};
+
+
+// spin for the other side, yield now and then so a shared or busy cpu still makes progress
+void wait_for(const std::atomic<uint64_t>& sequence, uint64_t value)
+{
+    unsigned int spins{0};
+    while (sequence.load(std::memory_order_acquire) != value) {
+        if (++spins % 4096) CpuRelax();
+        else LinuxThread::Yield();
+    }
+}
+
+
+// one way latency in ns between cpu_a and cpu_b
+double measure(int cpu_a, int cpu_b, uint64_t round_trips)
+{
+    PingPong line;
+    std::atomic<bool> ready{false};
+    double elapsed_ns{0};
+
+    // b answers odd values, a times the round trips
+    LinuxThread pong([&]() {
+        ready.store(true, std::memory_order_release);
+        for (uint64_t trip = 0; trip < round_trips; trip++) {
+            wait_for(line.sequence, 2 * trip + 1);
+            line.sequence.store(2 * trip + 2, std::memory_order_release);
+        }
+    }, static_cast<unsigned int>(cpu_b));
+
+    LinuxThread ping([&]() {
+        while (!ready.load(std::memory_order_acquire)) CpuRelax();
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t trip = 0; trip < round_trips; trip++) {
+            line.sequence.store(2 * trip + 1, std::memory_order_release);
+            wait_for(line.sequence, 2 * trip + 2);
+        }
+        elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }, static_cast<unsigned int>(cpu_a));
+
+    ping.Join();
+    pong.Join();
+    return elapsed_ns / round_trips / 2;
+}
+
+
+// lower side of the largest ratio between consecutive sorted latencies
+double gap_threshold(std::vector<double> latencies)
+{
+    std::sort(latencies.begin(), latencies.end());
+    double threshold = latencies.back();
+    double largest_ratio{1.0};
+    for (std::size_t idx = 1; idx < latencies.size(); idx++) {
+        double ratio = latencies[idx] / latencies[idx - 1];
+        if (ratio > largest_ratio) {
+            largest_ratio = ratio;
+            threshold = latencies[idx - 1];
+        }
+    }
+    // uniform machine : everything is one cluster
+    return (largest_ratio < 1.5) ? latencies.back() : threshold;
+}
+
+
+int find(std::vector<int>& parent, int idx)
+{
+    while (parent[idx] != idx) idx = parent[idx] = parent[parent[idx]];
+    return idx;
+}
+
+
+int main(int argc, char* argv[])
+{
+    uint64_t round_trips{20000};
+    int repeats{3};
+    double threshold_ns{0};
+    cpu_set_t cpuset = CpuTopology::EffectiveCpus();
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:c:t:")) != -1) {
+        switch (opt) {
+        case 'n': round_trips = std::strtoull(optarg, nullptr, 10); break;
+        case 'r': repeats = std::max(1, std::atoi(optarg)); break;
+        case 'c': {
+            // only cpus this process may use
+            cpu_set_t requested;
+            CPU_ZERO(&requested);
+            for (int cpu : CpuTopology::ParseCpuList(optarg)) CPU_SET(cpu, &requested);
+            CPU_AND(&cpuset, &cpuset, &requested);
+            break;
+        }
+        case 't': threshold_ns = std::atof(optarg); break;
+        default:
+            std::fprintf(stderr, "usage: %s [-n round_trips] [-r repeats] [-c cpu_list] [-t threshold_ns]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &cpuset)) cpus.push_back(cpu);
+    }
+    std::size_t count = cpus.size();
+    std::printf("cpus %s, %lu round trips, best of %d\n", CpuTopology::FormatCpuList(cpuset).c_str(), round_trips, repeats);
+    if (count < 2) {
+        std::printf("need at least two cpus\nclusters=%s\n", CpuTopology::FormatCpuList(cpuset).c_str());
+        return 0;
+    }
+
+    std::vector<std::vector<double>> matrix(count, std::vector<double>(count, 0.0));
+    std::vector<double> latencies;
+    for (std::size_t a = 0; a < count; a++) {
+        for (std::size_t b = a + 1; b < count; b++) {
+            double best = measure(cpus[a], cpus[b], round_trips);
+            for (int repeat = 1; repeat < repeats; repeat++) best = std::min(best, measure(cpus[a], cpus[b], round_trips));
+            matrix[a][b] = matrix[b][a] = best;
+            latencies.push_back(best);
+        }
+    }
+
+    // matrix, one way ns
+    std::printf("%6s", "cpu");
+    for (int cpu : cpus) std::printf(" %7d", cpu);
+    std::printf("\n");
+    for (std::size_t a = 0; a < count; a++) {
+        std::printf("%6d", cpus[a]);
+        for (std::size_t b = 0; b < count; b++) {
+            if (a == b) std::printf(" %7s", "-");
+            else std::printf(" %7.1f", matrix[a][b]);
+        }
+        std::printf("\n");
+    }
+
+    // join every pair at or below the threshold
+    if (threshold_ns <= 0) threshold_ns = gap_threshold(latencies);
+    std::vector<int> parent(count);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (std::size_t a = 0; a < count; a++) {
+        for (std::size_t b = a + 1; b < count; b++) {
+            if (matrix[a][b] <= threshold_ns) parent[find(parent, a)] = find(parent, b);
+        }
+    }
+
+    std::vector<cpu_set_t> clusters;
+    std::vector<int> cluster_of(count, -1);
+    for (std::size_t idx = 0; idx < count; idx++) {
+        int root = find(parent, idx);
+        if (cluster_of[root] < 0) {
+            cluster_of[root] = clusters.size();
+            clusters.emplace_back();
+            CPU_ZERO(&clusters.back());
+        }
+        CPU_SET(cpus[idx], &clusters[cluster_of[root]]);
+    }
+
+    std::printf("threshold %.1f ns, %zu clusters\n", threshold_ns, clusters.size());
+    std::string line;
+    for (std::size_t idx = 0; idx < clusters.size(); idx++) {
+        std::string cpu_list = CpuTopology::FormatCpuList(clusters[idx]);
+        std::printf("cluster %zu : %s\n", idx, cpu_list.c_str());
+        line += (idx ? ";" : "") + cpu_list;
+    }
+    std::printf("clusters=%s\n", line.c_str());
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+// compiler options
+// $ g++ -O2 -std=c++20 -I../util -pthread main.cpp ../util/CoroScheduler.cpp ../util/ThreadPool.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o coroutine_tasks
+// $ clang++ -O2 -std=c++20 -I../util -pthread main.cpp ../util/CoroScheduler.cpp ../util/ThreadPool.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o coroutine_tasks
+
+// coroutine tasks on a few LinuxThread workers vs thread per task
+// - every job is the async_future async_function : num_stages passes, each pass sleeps and accumulates
+//   the coroutine version awaits a timer instead of sleeping and awaits a pool Future for the accumulate step
+// - reports wall time, peak RSS, peak thread count and context switches for both
+// $ ./coroutine_tasks [jobs] [stages] [stage_ms]
+
+#include "CoroScheduler.h"
+#include "Task.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <string>
+#include <sys/resource.h>
+#include <utility>
+#include <vector>
+
+
+// one pass of work, scheduled on the pool and awaited by the coroutine version
+int accumulate(int accum, int run_count)
+{
+    return accum + run_count;
+}
+
+
+std::pair<int, int> async_function(int instance_number, int num_stages, std::chrono::milliseconds stage)
+{
+    int accum{0};
+
+    for (int run_count = 0; run_count < num_stages; run_count++) {
+        accum = accumulate(accum, run_count);
+        std::this_thread::sleep_for(stage);
+    }
+
+    return std::make_pair(instance_number, accum);
+}
+
+
+Task<std::pair<int, int>> async_coroutine(CoroScheduler& scheduler, int instance_number, int num_stages, std::chrono::milliseconds stage)
+{
+    int accum{0};
+
+    for (int run_count = 0; run_count < num_stages; run_count++) {
+        accum = co_await scheduler.Await(Async(scheduler.GetExecutor(), [accum, run_count]() { return accumulate(accum, run_count); }));
+        co_await scheduler.Sleep(stage);
+    }
+
+    co_return std::make_pair(instance_number, accum);
+}
+
+
+// VmRSS in kB and Threads from /proc/self/status
+std::pair<long, long> process_status()
+{
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    long rss_kb{0}, threads{0};
+    while (status >> key) {
+        if ("VmRSS:" == key) status >> rss_kb;
+        else if ("Threads:" == key) status >> threads;
+    }
+    return {rss_kb, threads};
+}
+
+
+long context_switches()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+
+// samples RSS and thread count while func runs, func returns the checksum of all job results
+template <typename Func>
+void report(const char* runtime, Func func)
+{
+    std::atomic<bool> running{true};
+    long peak_rss_kb{0}, peak_threads{0};
+    std::thread sampler([&]() {
+        while (running.load(std::memory_order_relaxed)) {
+            auto [rss_kb, threads] = process_status();
+            if (rss_kb > peak_rss_kb) peak_rss_kb = rss_kb;
+            if (threads > peak_threads) peak_threads = threads;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+
+    long base_rss_kb = process_status().first;
+    long switches_start = context_switches();
+    auto start = std::chrono::steady_clock::now();
+
+    long checksum = func();
+
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    long switches = context_switches() - switches_start;
+    running = false;
+    sampler.join();
+
+    std::printf("%-16s %10.1f ms  peak rss %8ld kB (+%ld)  peak threads %6ld  context switches %8ld  checksum %ld\n",
+        runtime, elapsed_ms, peak_rss_kb, peak_rss_kb - base_rss_kb, peak_threads, switches, checksum);
+}
+
+
+int main(int argc, char* argv[])
+{
+    int jobs = (argc > 1) ? std::atoi(argv[1]) : 2000;
+    int stages = (argc > 2) ? std::atoi(argv[2]) : 5;
+    std::chrono::milliseconds stage((argc > 3) ? std::atoi(argv[3]) : 100);
+
+    std::printf("%d jobs, %d stages of %ld ms\n", jobs, stages, static_cast<long>(stage.count()));
+
+    {
+        CoroScheduler scheduler;
+        report("coroutine", [&]() {
+            std::vector<Future<std::pair<int, int>>> futures;
+            futures.reserve(jobs);
+            for (int i = 0; i < jobs; i++) futures.push_back(scheduler.Spawn(async_coroutine(scheduler, i, stages, stage)));
+            long checksum{0};
+            for (auto& result : WhenAll(std::move(futures)).Get()) checksum += result.first + result.second;
+            return checksum;
+        });
+    }
+
+    report("thread per task", [&]() {
+        std::vector<std::future<std::pair<int, int>>> futures;
+        futures.reserve(jobs);
+        for (int i = 0; i < jobs; i++) futures.push_back(std::async(std::launch::async, async_function, i, stages, stage));
+        long checksum{0};
+        for (auto& future : futures) {
+            auto result = future.get();
+            checksum += result.first + result.second;
+        }
+        return checksum;
+    });
+
+    return 0;
+}
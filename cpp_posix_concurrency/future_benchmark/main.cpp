@@ -0,0 +1,123 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/ThreadPool.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o future_benchmark
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/ThreadPool.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o future_benchmark
+
+// continuation futures on a ThreadPool vs std::async
+// - chain : each small task consumes the previous result
+//   std::async blocks on get() and launches the next task, Future::Then() attaches a continuation
+// - fan out : independent small tasks joined by a blocking get() loop vs WhenAll()
+// - reports end to end time, distinct threads that ran tasks and context switches
+// $ ./future_benchmark [tasks]
+
+#include "Future.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+
+// tid of the thread that ran each task, one slot per task
+// - atomic : the losing WhenAny tasks may still be running while the report reads the slots
+static std::unique_ptr<std::atomic<pid_t>[]> task_tids;
+static std::size_t task_count;
+
+
+uint64_t step(uint64_t value, std::size_t task_idx)
+{
+    task_tids[task_idx].store(syscall(SYS_gettid), std::memory_order_relaxed);
+    return value * 31 + task_idx;
+}
+
+
+long context_switches()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+
+template <typename Func>
+void report(const char* benchmark, const char* executor, Func func)
+{
+    for (std::size_t idx = 0; idx < task_count; idx++) task_tids[idx].store(0, std::memory_order_relaxed);
+    long switches_start = context_switches();
+    auto start = std::chrono::steady_clock::now();
+
+    uint64_t result = func();
+
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    long switches = context_switches() - switches_start;
+
+    std::vector<pid_t> tids(task_count);
+    for (std::size_t idx = 0; idx < task_count; idx++) tids[idx] = task_tids[idx].load(std::memory_order_relaxed);
+    std::sort(tids.begin(), tids.end());
+    tids.erase(std::unique(tids.begin(), tids.end()), tids.end());
+    // tasks that had not run yet (WhenAny) left a 0
+    std::size_t threads = tids.size() - std::count(tids.begin(), tids.end(), 0);
+
+    std::printf("%-8s %-12s %10.2f ms  threads %6zu  context switches %7ld  result %lu\n",
+        benchmark, executor, elapsed_ms, threads, switches, result);
+}
+
+
+int main(int argc, char* argv[])
+{
+    std::size_t tasks = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    task_tids.reset(new std::atomic<pid_t>[tasks]);
+    task_count = tasks;
+
+    ThreadPool pool;
+    std::printf("%zu tasks, pool workers %u\n", tasks, pool.WorkerCount());
+
+    report("chain", "std::async", [tasks]() {
+        uint64_t value{0};
+        for (std::size_t idx = 0; idx < tasks; idx++) {
+            value = std::async(std::launch::async, step, value, idx).get();
+        }
+        return value;
+    });
+
+    report("chain", "Future::Then", [tasks, &pool]() {
+        Future<uint64_t> future = MakeReadyFuture<uint64_t>(0);
+        for (std::size_t idx = 0; idx < tasks; idx++) {
+            future = future.Then(pool, [idx](uint64_t value) { return step(value, idx); });
+        }
+        return future.Get();
+    });
+
+    report("fan_out", "std::async", [tasks]() {
+        std::vector<std::future<uint64_t>> futures;
+        for (std::size_t idx = 0; idx < tasks; idx++) futures.push_back(std::async(std::launch::async, step, 1, idx));
+        uint64_t sum{0};
+        for (auto& future : futures) sum += future.get();
+        return sum;
+    });
+
+    report("fan_out", "WhenAll", [tasks, &pool]() {
+        std::vector<Future<uint64_t>> futures;
+        for (std::size_t idx = 0; idx < tasks; idx++) futures.push_back(Async(pool, [idx]() { return step(1, idx); }));
+        return WhenAll(std::move(futures)).Then(pool, [](std::vector<uint64_t> values) {
+            uint64_t sum{0};
+            for (uint64_t value : values) sum += value;
+            return sum;
+        }).Get();
+    });
+
+    report("any", "WhenAny", [tasks, &pool]() {
+        std::vector<Future<uint64_t>> futures;
+        for (std::size_t idx = 0; idx < tasks; idx++) futures.push_back(Async(pool, [idx]() { return step(1, idx); }));
+        return static_cast<uint64_t>(WhenAny(std::move(futures)).Get().first);
+    });
+
+    return 0;
+}
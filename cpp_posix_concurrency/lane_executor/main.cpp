@@ -0,0 +1,150 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/LaneExecutor.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o lane_executor
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/LaneExecutor.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o lane_executor
+
+// request handling next to background compaction, one shared lane vs lanes per scheduling class
+// - compaction (bulk) and housekeeping tasks keep their lanes saturated by resubmitting themselves
+// - short request tasks are submitted at a fixed rate, latency is submit to completion
+// - every worker is pinned to the same cpu so the lanes really compete for it
+// - shared : one SCHED_OTHER lane for everything, requests queue behind compaction
+// - lanes : request on SCHED_FIFO, bulk on SCHED_BATCH nice 10, housekeeping on SCHED_IDLE
+//   (needs CAP_SYS_NICE or an rtprio limit for SCHED_FIFO, otherwise that lane inherits SCHED_OTHER)
+// $ ./lane_executor [requests] [request interval us]
+
+#include "CpuTopology.h"
+#include "LaneExecutor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr auto kCompactionSlice = std::chrono::milliseconds(4);
+static constexpr auto kHousekeepingSlice = std::chrono::milliseconds(2);
+static constexpr auto kRequestWork = std::chrono::microseconds(50);
+
+
+void busy(Clock::duration duration)
+{
+    auto end = Clock::now() + duration;
+    while (Clock::now() < end) {}
+}
+
+
+// background work, resubmits itself to its lane until stopped
+struct Background
+{
+    LaneExecutor& executor;
+    std::size_t lane;
+    Clock::duration slice;
+    std::atomic<bool>& stop;
+    std::atomic<uint64_t>& slices;
+
+    void operator()() const
+    {
+        if (stop.load(std::memory_order_relaxed)) return;
+        busy(slice);
+        slices.fetch_add(1, std::memory_order_relaxed);
+        if (!stop.load(std::memory_order_relaxed)) executor.Submit(lane, *this);
+    }
+};
+
+
+struct Result
+{
+    std::vector<int64_t> latencies_us;
+    uint64_t compaction_slices;
+    uint64_t housekeeping_slices;
+};
+
+
+// lanes[0] requests, lanes[1] compaction, lanes[2] housekeeping, lanes may repeat an index
+Result run(std::vector<LaneExecutor::LaneConfig> configs, const std::size_t lanes[3], int requests, std::chrono::microseconds interval)
+{
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> compaction_slices{0};
+    std::atomic<uint64_t> housekeeping_slices{0};
+    std::vector<int64_t> latencies_us(requests, 0);
+    std::atomic<int> done{0};
+
+    {
+        LaneExecutor executor(std::move(configs));
+        for (int idx = 0; idx < 2; idx++) {
+            executor.Submit(lanes[1], Background{executor, lanes[1], kCompactionSlice, stop, compaction_slices});
+            executor.Submit(lanes[2], Background{executor, lanes[2], kHousekeepingSlice, stop, housekeeping_slices});
+        }
+
+        auto next = Clock::now();
+        for (int idx = 0; idx < requests; idx++) {
+            next += interval;
+            std::this_thread::sleep_until(next);
+            auto submitted = Clock::now();
+            executor.Submit(lanes[0], [&latencies_us, &done, idx, submitted]() {
+                busy(kRequestWork);
+                latencies_us[idx] = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - submitted).count();
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        while (done.load(std::memory_order_acquire) < requests) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        stop = true;
+        executor.Report();
+    }
+
+    return {latencies_us, compaction_slices.load(), housekeeping_slices.load()};
+}
+
+
+void print(const char* name, Result result)
+{
+    std::vector<int64_t>& latencies = result.latencies_us;
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double pct) {
+        return static_cast<long>(latencies[static_cast<std::size_t>(pct * (latencies.size() - 1))]);
+    };
+    std::printf("%-8s %10ld %10ld %10ld %12llu %14llu\n", name, percentile(0.5), percentile(0.99), percentile(1.0),
+        static_cast<unsigned long long>(result.compaction_slices), static_cast<unsigned long long>(result.housekeeping_slices));
+}
+
+
+int main(int argc, char* argv[])
+{
+    int requests = (argc > 1) ? std::atoi(argv[1]) : 500;
+    std::chrono::microseconds interval((argc > 2) ? std::atoi(argv[2]) : 2000);
+    if (requests <= 0 || interval.count() <= 0) {
+        std::fprintf(stderr, "usage : %s [requests] [request interval us]\n", argv[0]);
+        return 1;
+    }
+
+    unsigned int cpu = CpuTopology::EffectiveCpu(0);
+
+    // one lane, three workers
+    const std::size_t shared_lanes[3] = {0, 0, 0};
+    Result shared = run({{"shared", SCHED_OTHER, 0, 3, cpu}}, shared_lanes, requests, interval);
+
+    // one worker per scheduling class
+    const std::size_t class_lanes[3] = {0, 1, 2};
+    Result lanes = run({
+        {"request", SCHED_FIFO, 10, 1, cpu},
+        {"bulk", SCHED_BATCH, 10, 1, cpu},
+        {"housekeeping", SCHED_IDLE, 0, 1, cpu}}, class_lanes, requests, interval);
+
+    std::printf("%d requests every %ld us, %ld us of work each, all workers on cpu %u\n", requests,
+        static_cast<long>(interval.count()), static_cast<long>(kRequestWork.count()), cpu);
+    std::printf("%-8s %10s %10s %10s %12s %14s\n", "config", "p50 us", "p99 us", "max us", "compaction", "housekeeping");
+    print("shared", shared);
+    print("lanes", lanes);
+
+    return 0;
+}
@@ -0,0 +1,280 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o mpmc_benchmark
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o mpmc_benchmark
+
+// MpmcQueue vs a std::mutex + std::condition_variable bounded queue
+// - producers and consumers each double from 1 up to the effective cpu count (at least 4)
+// - every item carries its push time, consumers sample push to pop latency of every 16th item
+// - mpmc_batch moves items 32 at a time through PushBatch / PopBatch
+// - the id checksum catches lost or duplicated items
+// $ ./mpmc_benchmark [items per run] [queue capacity]
+
+#include "CpuTopology.h"
+#include "LinuxThread.h"
+#include "MpmcQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+struct Item
+{
+    uint64_t id;
+    int64_t pushed_ns;
+};
+
+
+// bounded queue the way it is usually written with the standard library
+template <typename T>
+class MutexQueue
+{
+
+public:
+
+    explicit MutexQueue(std::size_t capacity) :
+        capacity_(capacity)
+    {
+    }
+
+    bool Push(T item)
+    {
+        std::unique_lock<std::mutex> lck(mtx_);
+        not_full_.wait(lck, [this]() { return closed_ || items_.size() < capacity_; });
+        if (closed_) return false;
+        items_.push_back(std::move(item));
+        lck.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    bool Pop(T& item)
+    {
+        std::unique_lock<std::mutex> lck(mtx_);
+        not_empty_.wait(lck, [this]() { return closed_ || !items_.empty(); });
+        if (items_.empty()) return false;
+        item = std::move(items_.front());
+        items_.pop_front();
+        lck.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lck(mtx_);
+            closed_ = true;
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+private:
+
+    std::mutex mtx_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<T> items_;
+    std::size_t capacity_;
+    bool closed_{false};
+};
+
+
+// MpmcQueue driven through the batch calls
+class BatchQueue
+{
+
+public:
+
+    static constexpr std::size_t kBatch = 32;
+
+    explicit BatchQueue(std::size_t capacity) :
+        queue_(capacity)
+    {
+    }
+
+    MpmcQueue<Item>& Queue()
+    {
+        return queue_;
+    }
+
+private:
+
+    MpmcQueue<Item> queue_;
+};
+
+
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// range of ids [begin, end) for one producer
+struct Range
+{
+    uint64_t begin;
+    uint64_t end;
+};
+
+
+Range producer_range(uint64_t items, unsigned int producers, unsigned int idx)
+{
+    return {items * idx / producers, items * (idx + 1) / producers};
+}
+
+
+void produce(MutexQueue<Item>& queue, Range range)
+{
+    for (uint64_t id = range.begin; id < range.end; id++) queue.Push({id, now_ns()});
+}
+
+
+void produce(MpmcQueue<Item>& queue, Range range)
+{
+    for (uint64_t id = range.begin; id < range.end; id++) queue.Push(Item{id, now_ns()});
+}
+
+
+void produce(BatchQueue& batch_queue, Range range)
+{
+    Item items[BatchQueue::kBatch];
+    for (uint64_t id = range.begin; id < range.end;) {
+        std::size_t count = std::min<uint64_t>(BatchQueue::kBatch, range.end - id);
+        int64_t stamp = now_ns();
+        for (std::size_t idx = 0; idx < count; idx++) items[idx] = {id + idx, stamp};
+        batch_queue.Queue().PushBatch(items, count);
+        id += count;
+    }
+}
+
+
+struct Consumed
+{
+    uint64_t count{0};
+    uint64_t checksum{0};
+    std::vector<int64_t> latencies;
+
+    void Take(const Item& item)
+    {
+        if (0 == (item.id & 15)) latencies.push_back(now_ns() - item.pushed_ns);
+        count++;
+        checksum += item.id;
+    }
+};
+
+
+template <typename Queue>
+void consume(Queue& queue, Consumed& consumed)
+{
+    Item item;
+    while (queue.Pop(item)) consumed.Take(item);
+}
+
+
+void consume(BatchQueue& batch_queue, Consumed& consumed)
+{
+    Item items[BatchQueue::kBatch];
+    while (std::size_t count = batch_queue.Queue().PopBatch(items, BatchQueue::kBatch)) {
+        for (std::size_t idx = 0; idx < count; idx++) consumed.Take(items[idx]);
+    }
+}
+
+
+void close(MutexQueue<Item>& queue)
+{
+    queue.Close();
+}
+
+
+void close(MpmcQueue<Item>& queue)
+{
+    queue.Close();
+}
+
+
+void close(BatchQueue& batch_queue)
+{
+    batch_queue.Queue().Close();
+}
+
+
+template <typename Queue>
+void run(const char* name, unsigned int producers, unsigned int consumers, uint64_t items, std::size_t capacity)
+{
+    Queue queue(capacity);
+    std::vector<Consumed> consumed(consumers);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::unique_ptr<LinuxThread>> consumer_threads;
+        for (unsigned int idx = 0; idx < consumers; idx++) {
+            consumer_threads.push_back(std::make_unique<LinuxThread>([&queue, &consumed, idx]() {
+                consume(queue, consumed[idx]);
+            }, CpuTopology::EffectiveCpu(producers + idx)));
+        }
+        {
+            std::vector<std::unique_ptr<LinuxThread>> producer_threads;
+            for (unsigned int idx = 0; idx < producers; idx++) {
+                Range range = producer_range(items, producers, idx);
+                producer_threads.push_back(std::make_unique<LinuxThread>([&queue, range]() {
+                    produce(queue, range);
+                }, CpuTopology::EffectiveCpu(idx)));
+            }
+        }
+        close(queue);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t count{0};
+    uint64_t checksum{0};
+    std::vector<int64_t> latencies;
+    for (const Consumed& consumer : consumed) {
+        count += consumer.count;
+        checksum += consumer.checksum;
+        latencies.insert(latencies.end(), consumer.latencies.begin(), consumer.latencies.end());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double pct) {
+        return latencies.empty() ? 0 : latencies[static_cast<std::size_t>(pct * (latencies.size() - 1))];
+    };
+
+    bool intact = (count == items) && (checksum == items * (items - 1) / 2);
+    std::printf("%4u %4u %-12s %14.0f %12ld %12ld%s\n", producers, consumers, name, count / elapsed,
+        static_cast<long>(percentile(0.5)), static_cast<long>(percentile(0.99)), intact ? "" : "  LOST / DUPLICATED ITEMS");
+}
+
+
+int main(int argc, char* argv[])
+{
+    uint64_t items = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    std::size_t capacity = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 1024;
+    if (0 == items || 0 == capacity) {
+        std::fprintf(stderr, "usage : %s [items per run] [queue capacity]\n", argv[0]);
+        return 1;
+    }
+
+    unsigned int cpus = CpuTopology::EffectiveConcurrency();
+    std::vector<unsigned int> thread_counts;
+    for (unsigned int num_threads = 1; num_threads <= std::max(cpus, 4u); num_threads *= 2) thread_counts.push_back(num_threads);
+
+    std::printf("%u effective cpus, %llu items per run, capacity %zu\n", cpus, static_cast<unsigned long long>(items), capacity);
+    std::printf("%4s %4s %-12s %14s %12s %12s\n", "prod", "cons", "queue", "items/sec", "p50 ns", "p99 ns");
+    for (unsigned int producers : thread_counts) {
+        for (unsigned int consumers : thread_counts) {
+            run<MutexQueue<Item>>("mutex_cv", producers, consumers, items, capacity);
+            run<MpmcQueue<Item>>("mpmc", producers, consumers, items, capacity);
+            run<BatchQueue>("mpmc_batch", producers, consumers, items, capacity);
+        }
+    }
+
+    return 0;
+}
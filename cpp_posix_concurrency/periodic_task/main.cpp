@@ -0,0 +1,128 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/PeriodicTask.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o periodic_task
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/PeriodicTask.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o periodic_task
+
+// control loop on a PeriodicTask vs the same loop on relative sleep_for
+// - the cycle burns work_us, every overrun_every-th cycle burns 2.5 periods instead (overrun + skipped cycles)
+// - the PeriodicTask runs SCHED_FIFO 80 with a prefaulted stack when permitted, its stats are reported live
+// - drift : wall time actually taken minus cycles * period, sleep_for adds every cycle's execution time and
+//   wakeup latency, the absolute grid adds nothing
+// $ sudo ./periodic_task [-p period_us] [-w work_us] [-o overrun_every] [-d seconds]
+
+#include "PeriodicTask.h"
+#include "SyncLog.h"
+#include "ThreadAttributes.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+
+struct Options
+{
+    long period_us{1000};
+    long work_us{200};
+    long overrun_every{200};
+    long seconds{3};
+};
+
+
+int64_t now_ns(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+void burn(long work_us)
+{
+    int64_t start = now_ns(CLOCK_THREAD_CPUTIME_ID);
+    while (now_ns(CLOCK_THREAD_CPUTIME_ID) - start < work_us * 1000) {}
+}
+
+
+// the control law, cycle counts are its own so both loops see the same overrun pattern
+struct Controller
+{
+    const Options& options;
+    long cycle{0};
+
+    void operator()()
+    {
+        cycle++;
+        bool overrun = options.overrun_every && 0 == cycle % options.overrun_every;
+        burn(overrun ? options.period_us * 5 / 2 : options.work_us);
+    }
+};
+
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "p:w:o:d:"))) {
+        switch (opt) {
+            case 'p': options.period_us = std::atol(optarg); break;
+            case 'w': options.work_us = std::atol(optarg); break;
+            case 'o': options.overrun_every = std::atol(optarg); break;
+            case 'd': options.seconds = std::atol(optarg); break;
+            default:
+                std::fprintf(stderr, "usage : %s [-p period_us] [-w work_us] [-o overrun_every] [-d seconds]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (options.period_us <= 0 || options.work_us < 0 || options.seconds <= 0) {
+        std::fprintf(stderr, "period and duration must be positive\n");
+        return 1;
+    }
+
+    std::chrono::microseconds period(options.period_us);
+
+    // absolute grid
+    Controller controller{options};
+    int64_t origin = now_ns(CLOCK_MONOTONIC);
+    int64_t elapsed_ns;
+    PeriodicTask::PeriodicStats stats;
+    {
+        PeriodicTask task("control_loop", period, [&controller]() { controller(); },
+            ThreadAttributes().Policy(SCHED_FIFO).Priority(80).RealTime(64 * 1024));
+
+        for (long tick = 0; tick < options.seconds * 2; tick++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            task.Report();
+        }
+        task.Stop();
+        elapsed_ns = now_ns(CLOCK_MONOTONIC) - origin;
+        stats = task.Stats();
+    }
+    // the last release was at most one period before Stop() returned
+    int64_t grid_ns = static_cast<int64_t>(stats.cycles + stats.skipped) * options.period_us * 1000;
+
+    // relative sleep for the same number of cycles
+    Controller relative_controller{options};
+    origin = now_ns(CLOCK_MONOTONIC);
+    for (uint64_t cycle = 0; cycle < stats.cycles + stats.skipped; cycle++) {
+        relative_controller();
+        std::this_thread::sleep_for(period);
+    }
+    int64_t relative_ns = now_ns(CLOCK_MONOTONIC) - origin;
+    int64_t relative_grid_ns = static_cast<int64_t>(stats.cycles + stats.skipped) * options.period_us * 1000;
+
+    std::printf("period %ld us, work %ld us, overrun every %ld cycles\n", options.period_us, options.work_us, options.overrun_every);
+    std::printf("periodic task : cycles %llu, overruns %llu, skipped %llu, jitter avg %.1f max %.1f us, exec avg %.1f max %.1f us\n",
+        static_cast<unsigned long long>(stats.cycles), static_cast<unsigned long long>(stats.overruns),
+        static_cast<unsigned long long>(stats.skipped), stats.jitter_avg_ns / 1000.0, stats.jitter_max_ns / 1000.0,
+        stats.exec_avg_ns / 1000.0, stats.exec_max_ns / 1000.0);
+    std::printf("drift over %.2f s : absolute grid %+.1f ms (< one period), relative sleep_for %+.1f ms\n",
+        elapsed_ns / 1e9, (elapsed_ns - grid_ns) / 1e6, (relative_ns - relative_grid_ns) / 1e6);
+
+    return 0;
+}
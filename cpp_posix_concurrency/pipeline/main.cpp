@@ -0,0 +1,117 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o pipeline
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o pipeline
+
+// promise_future processing states as a pinned pipeline
+// - every record moves through PROC_STATE_0 .. PROC_STATE_2, each state is a stage on its own core,
+//   PROC_STATE_COMPLETED is the sink
+// - the same records are first processed by one thread running every state in turn
+// - slow_stage gets slow_factor times the work so it shows up as the bottleneck in the stage report
+// $ ./pipeline [records] [work] [slow_stage] [slow_factor]
+
+#include "CpuTopology.h"
+#include "Pipeline.h"
+#include "SyncLog.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+
+enum ProcessingState {
+  PROC_STATE_0 = 0,
+  PROC_STATE_1 = 1,
+  PROC_STATE_2 = 2,
+  PROC_STATE_COMPLETED = 3
+};
+
+
+struct Record
+{
+    int instance_number;
+    int processing_state;
+    uint64_t accum;
+};
+
+
+// work units per state, the slow state does more
+static std::vector<int> state_work(PROC_STATE_COMPLETED);
+
+
+void process(Record& record)
+{
+    uint64_t accum = record.accum;
+    for (int i = 0; i < state_work[record.processing_state]; i++) accum = accum * 6364136223846793005ULL + record.instance_number;
+    record.accum = accum;
+    record.processing_state += 1;
+}
+
+
+int main(int argc, char* argv[])
+{
+    int records = (argc > 1) ? std::atoi(argv[1]) : 1000000;
+    int work = (argc > 2) ? std::atoi(argv[2]) : 100;
+    int slow_stage = (argc > 3) ? std::atoi(argv[3]) : PROC_STATE_1;
+    int slow_factor = (argc > 4) ? std::atoi(argv[4]) : 2;
+
+    for (int state = PROC_STATE_0; state < PROC_STATE_COMPLETED; state++) {
+        state_work[state] = (state == slow_stage) ? work * slow_factor : work;
+    }
+
+    std::printf("%d records, work per state %d, state %d x%d\n", records, work, slow_stage, slow_factor);
+
+    // one thread runs every state
+    uint64_t serial_checksum{0};
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < records; i++) {
+            Record record{i, PROC_STATE_0, 0};
+            while (record.processing_state < PROC_STATE_COMPLETED) process(record);
+            serial_checksum += record.accum;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-10s %10.1f ms  %12.0f records/s\n", "serial", seconds * 1e3, records / seconds);
+    }
+
+    // a stage per state plus the sink, spread over physical cores
+    uint64_t pipeline_checksum{0};
+    uint64_t out_of_order{0};
+    {
+        std::vector<cpu_set_t> cpus = CpuTopology::Load().Place(CpuTopology::Placement::SPREAD_CORES, PROC_STATE_COMPLETED + 1);
+
+        Pipeline<Record> pipeline(1024, 64);
+        for (int state = PROC_STATE_0; state < PROC_STATE_COMPLETED; state++) {
+            pipeline.AddStage("PROC_STATE_" + std::to_string(state), process, ThreadAttributes().Affinity(cpus[state]));
+        }
+        pipeline.AddStage("PROC_STATE_COMPLETED", [&, expected = 0](Record& record) mutable {
+            if (PROC_STATE_COMPLETED != record.processing_state || expected++ != record.instance_number) out_of_order++;
+            pipeline_checksum += record.accum;
+        }, ThreadAttributes().Affinity(cpus[PROC_STATE_COMPLETED]));
+
+        auto start = std::chrono::steady_clock::now();
+        pipeline.Start();
+
+        for (int i = 0; i < records; i++) {
+            pipeline.Push(Record{i, PROC_STATE_0, 0});
+            // snapshot while the stream is flowing
+            if (i == records / 2) {
+                SyncLog::GetLog()->Log("mid stream");
+                pipeline.Report();
+            }
+        }
+        pipeline.Close();
+        pipeline.Wait();
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-10s %10.1f ms  %12.0f records/s\n", "pipeline", seconds * 1e3, records / seconds);
+        SyncLog::GetLog()->Log("end of stream");
+        pipeline.Report();
+    }
+
+    bool ok = (serial_checksum == pipeline_checksum) && (0 == out_of_order);
+    std::printf("checksum %s, out of order %lu\n", ok ? "match" : "MISMATCH", out_of_order);
+
+    return ok ? 0 : 1;
+}
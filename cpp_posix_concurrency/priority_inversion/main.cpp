@@ -0,0 +1,162 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o priority_inversion
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o priority_inversion
+
+// classic priority inversion on one cpu, with and without priority inheritance
+// - low (SCHED_FIFO low_prio) wakes first, takes the lock and burns hold_us of cpu inside it
+// - medium (SCHED_FIFO low_prio + 10) wakes next, preempts low and burns hog_us of cpu, it never touches the lock
+// - high (SCHED_FIFO low_prio + 20) wakes last and blocks on the lock, the time from its scheduled wakeup
+//   to owning the lock is measured (from the wakeup, a ceiling holder keeps high off the cpu until it unlocks)
+// - NONE : medium keeps low off the cpu, high waits roughly hog_us + the rest of hold_us
+//   INHERIT : low runs at high's priority once high blocks, high waits roughly the rest of hold_us
+//   PROTECT : low runs at the ceiling (high's priority) as soon as it locks, medium can not preempt it at all
+// - all three threads are pinned to the same cpu, every trial starts on an absolute period boundary
+// needs root (or rtprio in /etc/security/limits.conf) for SCHED_FIFO
+// $ sudo ./priority_inversion [-t trials] [-H hold_us] [-m hog_us] [-p low_prio]
+
+#include "CpuTopology.h"
+#include "LinuxThread.h"
+#include "PiMutex.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+
+static constexpr int64_t kPeriodNs = 20000000;
+// wake order inside a period : low, then medium, then high
+static constexpr int64_t kMediumOffsetNs = 100000;
+static constexpr int64_t kHighOffsetNs = 200000;
+
+
+int64_t to_ns(const timespec& ts)
+{
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+int64_t now_ns(clockid_t clock = CLOCK_MONOTONIC)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return to_ns(ts);
+}
+
+
+void sleep_until(int64_t deadline_ns)
+{
+    timespec ts{static_cast<time_t>(deadline_ns / 1000000000), static_cast<long>(deadline_ns % 1000000000)};
+    while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr)) {}
+}
+
+
+// cpu time, not wall time, so being preempted does not shorten the work
+void burn_cpu(int64_t duration_ns)
+{
+    int64_t end = now_ns(CLOCK_THREAD_CPUTIME_ID) + duration_ns;
+    while (now_ns(CLOCK_THREAD_CPUTIME_ID) < end) {}
+}
+
+
+struct Result
+{
+    int64_t max_ns{0};
+    int64_t sum_ns{0};
+    int64_t samples{0};
+};
+
+
+Result run(PiMutex::Protocol protocol, int trials, int64_t hold_ns, int64_t hog_ns, int low_prio)
+{
+    PiMutex mtx(protocol, low_prio + 20);
+    std::vector<int64_t> blocked_ns(trials);
+
+    cpu_set_t cpus = LinuxThread::CpuSet(CpuTopology::EffectiveCpu(0));
+    auto fifo = [&cpus](int priority) {
+        return ThreadAttributes().Policy(SCHED_FIFO).Priority(priority).Affinity(cpus);
+    };
+
+    // first trial a few periods out so every thread is parked before it starts
+    int64_t start_ns = now_ns() + 5 * kPeriodNs;
+    {
+        LinuxThread low([&]() {
+            for (int trial = 0; trial < trials; trial++) {
+                sleep_until(start_ns + trial * kPeriodNs);
+                std::lock_guard<PiMutex> lck (mtx);
+                burn_cpu(hold_ns);
+            }
+        }, fifo(low_prio));
+
+        LinuxThread medium([&]() {
+            for (int trial = 0; trial < trials; trial++) {
+                sleep_until(start_ns + trial * kPeriodNs + kMediumOffsetNs);
+                burn_cpu(hog_ns);
+            }
+        }, fifo(low_prio + 10));
+
+        LinuxThread high([&]() {
+            for (int trial = 0; trial < trials; trial++) {
+                int64_t wakeup_ns = start_ns + trial * kPeriodNs + kHighOffsetNs;
+                sleep_until(wakeup_ns);
+                std::lock_guard<PiMutex> lck (mtx);
+                blocked_ns[trial] = now_ns() - wakeup_ns;
+            }
+        }, fifo(low_prio + 20));
+    }
+
+    Result result;
+    for (int64_t ns : blocked_ns) {
+        result.max_ns = std::max(result.max_ns, ns);
+        result.sum_ns += ns;
+        result.samples++;
+    }
+    return result;
+}
+
+
+int main(int argc, char* argv[])
+{
+    int trials{50};
+    int64_t hold_us{1000};
+    int64_t hog_us{5000};
+    int low_prio{10};
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:H:m:p:")) != -1) {
+        switch (opt) {
+        case 't': trials = std::atoi(optarg); break;
+        case 'H': hold_us = std::atoll(optarg); break;
+        case 'm': hog_us = std::atoll(optarg); break;
+        case 'p': low_prio = std::atoi(optarg); break;
+        default:
+            std::fprintf(stderr, "usage: %s [-t trials] [-H hold_us] [-m hog_us] [-p low_prio]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (hold_us * 1000 + hog_us * 1000 + kHighOffsetNs >= kPeriodNs) {
+        std::fprintf(stderr, "hold_us + hog_us must fit in the %ld us period\n", static_cast<long>(kPeriodNs / 1000));
+        return 1;
+    }
+    if (0 != geteuid()) std::fprintf(stderr, "not root : SCHED_FIFO is likely refused and the results are meaningless\n");
+
+    std::printf("%d trials, low holds %ld us of cpu, medium hogs %ld us, priorities %d / %d / %d on cpu %u\n",
+        trials, static_cast<long>(hold_us), static_cast<long>(hog_us), low_prio, low_prio + 10, low_prio + 20,
+        CpuTopology::EffectiveCpu(0));
+    std::printf("%-10s %16s %16s\n", "protocol", "avg blocked(us)", "max blocked(us)");
+
+    for (auto protocol : {PiMutex::Protocol::NONE, PiMutex::Protocol::INHERIT, PiMutex::Protocol::PROTECT}) {
+        Result result = run(protocol, trials, hold_us * 1000, hog_us * 1000, low_prio);
+        std::printf("%-10s %16.1f %16.1f\n",
+            (PiMutex::Protocol::NONE == protocol) ? "NONE" : (PiMutex::Protocol::INHERIT == protocol) ? "INHERIT" : "PROTECT",
+            result.sum_ns / 1e3 / result.samples, result.max_ns / 1e3);
+    }
+
+    return 0;
+}
@@ -0,0 +1,374 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/EpochReclaimer.cpp ../util/HazardPointers.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o reclamation_benchmark
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/EpochReclaimer.cpp ../util/HazardPointers.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o reclamation_benchmark
+
+// reclamation overhead in a read-mostly sorted linked list
+// - readers look up random keys, one writer replaces random nodes (copy, mark the old node, swing the
+//   predecessor, retire the old node) and does 9 lookups between two updates
+// - leak : retired nodes are only freed after the run, the cost of reading with no reclamation at all
+// - ebr : EpochReclaimer, one guard per lookup
+// - hazard : HazardPointers, hand over hand with two hazards, a lookup restarts when it meets a removed node
+// - stalled : one more thread holds a guard / a hazard for the whole run. Pending nodes grow with every
+//   update under ebr, hazard pointers keep them bounded
+// - every value read is checked against its key, ASan catches a node freed too early
+// $ ./reclamation_benchmark [list length] [milliseconds per run] [readers]
+
+#include "CacheLine.h"
+#include "CpuTopology.h"
+#include "EpochReclaimer.h"
+#include "HazardPointers.h"
+#include "LinuxThread.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+struct Node
+{
+    Node(uint64_t node_key, uint64_t node_value, Node* node_next) :
+        key(node_key),
+        value(node_value),
+        next(node_next)
+    {
+    }
+
+    const uint64_t key;
+    const uint64_t value;
+    // low bit set : this node is removed
+    std::atomic<Node*> next;
+};
+
+
+Node* marked(Node* node)
+{
+    return reinterpret_cast<Node*>(reinterpret_cast<uintptr_t>(node) | 1);
+}
+
+
+Node* unmarked(Node* node)
+{
+    return reinterpret_cast<Node*>(reinterpret_cast<uintptr_t>(node) & ~uintptr_t(1));
+}
+
+
+bool is_marked(Node* node)
+{
+    return reinterpret_cast<uintptr_t>(node) & 1;
+}
+
+
+// keys 0 .. length - 1 behind a sentinel head, value = key + length * version
+class List
+{
+
+public:
+
+    explicit List(uint64_t length) :
+        head_(0, 0, nullptr),
+        length_(length)
+    {
+        for (uint64_t key = length; key-- > 0;) head_.next.store(new Node(key, key, head_.next.load()));
+    }
+
+    ~List()
+    {
+        Node* node = head_.next.load();
+        while (node) {
+            Node* next = unmarked(node->next.load());
+            delete node;
+            node = next;
+        }
+    }
+
+    // Delete the copy constructor
+    List(const List&) = delete;
+
+    // Delete the Assignment opeartor
+    List& operator=(const List&) = delete;
+
+    Node& Head()
+    {
+        return head_;
+    }
+
+    uint64_t Length() const
+    {
+        return length_;
+    }
+
+    // single writer : reachable nodes never carry the mark, the caller retires the returned node
+    Node* Replace(uint64_t key, uint64_t version)
+    {
+        Node* prev = &head_;
+        Node* curr = head_.next.load(std::memory_order_relaxed);
+        while (curr->key < key) {
+            prev = curr;
+            curr = curr->next.load(std::memory_order_relaxed);
+        }
+        Node* next = curr->next.load(std::memory_order_relaxed);
+        Node* node = new Node(key, key + length_ * version, next);
+        curr->next.store(marked(next), std::memory_order_release);
+        prev->next.store(node, std::memory_order_release);
+        return curr;
+    }
+
+private:
+
+    Node head_;
+    const uint64_t length_;
+};
+
+
+// walk without protection, the caller keeps the nodes alive
+bool find(List& list, uint64_t key, uint64_t& value)
+{
+    Node* curr = list.Head().next.load(std::memory_order_acquire);
+    while (curr && curr->key < key) curr = unmarked(curr->next.load(std::memory_order_acquire));
+    if (!curr || curr->key != key) return false;
+    value = curr->value;
+    return true;
+}
+
+
+struct Leak
+{
+    static constexpr const char* kName = "leak";
+
+    bool Lookup(List& list, uint64_t key, uint64_t& value)
+    {
+        return find(list, key, value);
+    }
+
+    // writer only
+    void Retire(Node* node)
+    {
+        retired.push_back(node);
+    }
+
+    std::size_t Pending()
+    {
+        return retired.size();
+    }
+
+    void Stall(List&, const std::atomic<bool>& stop)
+    {
+        while (!stop.load(std::memory_order_relaxed)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::size_t Finish()
+    {
+        for (Node* node : retired) delete node;
+        retired.clear();
+        return 0;
+    }
+
+    std::vector<Node*> retired;
+};
+
+
+struct Ebr
+{
+    static constexpr const char* kName = "ebr";
+
+    bool Lookup(List& list, uint64_t key, uint64_t& value)
+    {
+        EpochReclaimer::Guard guard;
+        return find(list, key, value);
+    }
+
+    void Retire(Node* node)
+    {
+        EpochReclaimer::GetReclaimer()->Retire(node);
+    }
+
+    std::size_t Pending()
+    {
+        return EpochReclaimer::GetReclaimer()->Stats().pending;
+    }
+
+    void Stall(List&, const std::atomic<bool>& stop)
+    {
+        EpochReclaimer::Guard guard;
+        while (!stop.load(std::memory_order_relaxed)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::size_t Finish()
+    {
+        EpochReclaimer::GetReclaimer()->Barrier();
+        return EpochReclaimer::GetReclaimer()->Stats().pending;
+    }
+};
+
+
+struct Hazard
+{
+    static constexpr const char* kName = "hazard";
+
+    bool Lookup(List& list, uint64_t key, uint64_t& value)
+    {
+        HazardPointers::Hazard first;
+        HazardPointers::Hazard second;
+        bool found{false};
+        while (!Walk(list, key, value, first, second, found)) {}
+        return found;
+    }
+
+    // false : met a removed node, start over from the head
+    bool Walk(List& list, uint64_t key, uint64_t& value, HazardPointers::Hazard& first,
+        HazardPointers::Hazard& second, bool& found)
+    {
+        HazardPointers::Hazard* prev_hazard = &first;
+        HazardPointers::Hazard* curr_hazard = &second;
+        Node* prev = &list.Head();
+        Node* curr = prev->next.load(std::memory_order_acquire);
+        while (curr) {
+            curr_hazard->Set(curr);
+            // prev unmarked and still pointing at curr : curr was reachable when the hazard went up
+            if (prev->next.load(std::memory_order_acquire) != curr) return false;
+            Node* next = curr->next.load(std::memory_order_acquire);
+            if (is_marked(next)) return false;
+            if (curr->key >= key) {
+                found = (curr->key == key);
+                if (found) value = curr->value;
+                return true;
+            }
+            prev = curr;
+            std::swap(prev_hazard, curr_hazard);
+            curr = next;
+        }
+        found = false;
+        return true;
+    }
+
+    void Retire(Node* node)
+    {
+        HazardPointers::GetDomain()->Retire(node);
+    }
+
+    std::size_t Pending()
+    {
+        return HazardPointers::GetDomain()->Stats().pending;
+    }
+
+    void Stall(List& list, const std::atomic<bool>& stop)
+    {
+        HazardPointers::Hazard hazard;
+        hazard.Protect(list.Head().next);
+        while (!stop.load(std::memory_order_relaxed)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::size_t Finish()
+    {
+        // picks up what the exited writer handed over
+        HazardPointers::GetDomain()->Scan();
+        return HazardPointers::GetDomain()->Stats().pending;
+    }
+};
+
+
+struct alignas(kCacheLineSize) Counter
+{
+    uint64_t reads{0};
+    uint64_t corrupt{0};
+};
+
+
+uint64_t next_random(uint64_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+
+template <typename Scheme>
+void lookup(Scheme& scheme, List& list, uint64_t& random, Counter& counter)
+{
+    uint64_t key = next_random(random) % list.Length();
+    uint64_t value{0};
+    if (!scheme.Lookup(list, key, value) || (value % list.Length()) != key) counter.corrupt++;
+    counter.reads++;
+}
+
+
+template <typename Scheme>
+void run(uint64_t length, long milliseconds, unsigned int readers, bool stalled)
+{
+    Scheme scheme;
+    List list(length);
+    std::atomic<bool> stop{false};
+    std::vector<Counter> counters(readers + 1);
+    uint64_t updates{0};
+    std::size_t peak_pending{0};
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::unique_ptr<LinuxThread>> threads;
+        for (unsigned int idx = 0; idx < readers; idx++) {
+            threads.push_back(std::make_unique<LinuxThread>([&scheme, &list, &stop, &counters, idx]() {
+                uint64_t random = 0x9e3779b97f4a7c15ull * (idx + 1);
+                while (!stop.load(std::memory_order_relaxed)) lookup(scheme, list, random, counters[idx]);
+            }, CpuTopology::EffectiveCpu(idx + 1)));
+        }
+        if (stalled) {
+            threads.push_back(std::make_unique<LinuxThread>([&scheme, &list, &stop]() {
+                scheme.Stall(list, stop);
+            }));
+        }
+        threads.push_back(std::make_unique<LinuxThread>([&]() {
+            uint64_t random = 0x2545f4914f6cdd1dull;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int idx = 0; idx < 9; idx++) lookup(scheme, list, random, counters[readers]);
+                scheme.Retire(list.Replace(next_random(random) % length, ++updates));
+                if (0 == (updates & 63)) peak_pending = std::max(peak_pending, scheme.Pending());
+            }
+        }, CpuTopology::EffectiveCpu(0)));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+        stop.store(true);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::size_t left = scheme.Finish();
+
+    uint64_t reads{0};
+    uint64_t corrupt{0};
+    for (const Counter& counter : counters) {
+        reads += counter.reads;
+        corrupt += counter.corrupt;
+    }
+    std::printf("%-8s %-8s %14.0f %12.0f %10.0f %14zu %10zu%s\n", Scheme::kName, stalled ? "yes" : "no",
+        reads / elapsed, updates / elapsed, 1e9 * elapsed * (readers + 1) / std::max<uint64_t>(reads, 1),
+        peak_pending, left, corrupt ? "  CORRUPT READS" : "");
+}
+
+
+int main(int argc, char* argv[])
+{
+    uint64_t length = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 256;
+    long milliseconds = (argc > 2) ? std::strtol(argv[2], nullptr, 10) : 1000;
+    unsigned int readers = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : std::max(CpuTopology::EffectiveConcurrency(), 4u) - 1;
+    if (0 == length || milliseconds <= 0 || 0 == readers) {
+        std::fprintf(stderr, "usage : %s [list length] [milliseconds per run] [readers]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%u effective cpus, %u readers + 1 writer, list length %llu, %ld ms per run\n",
+        CpuTopology::EffectiveConcurrency(), readers, static_cast<unsigned long long>(length), milliseconds);
+    std::printf("%-8s %-8s %14s %12s %10s %14s %10s\n", "scheme", "stalled", "reads/sec", "updates/sec", "ns/read",
+        "peak pending", "left");
+    for (bool stalled : {false, true}) {
+        run<Leak>(length, milliseconds, readers, stalled);
+        run<Ebr>(length, milliseconds, readers, stalled);
+        run<Hazard>(length, milliseconds, readers, stalled);
+    }
+
+    return 0;
+}
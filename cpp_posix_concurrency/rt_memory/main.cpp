@@ -0,0 +1,128 @@
+// compiler options
+// $ g++ -g -O2 -std=c++17 -I../util -pthread -ggdb -lpthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp ../util/RtAllocGuard.cpp -o rt_memory_demo
+// $ clang++ -g -O2 -std=c++17 -I../util -pthread -lpthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp ../util/RtAllocGuard.cpp -o rt_memory_demo
+
+// real-time memory hygiene demo
+// - a plain SCHED_FIFO thread, then after mlockall and heap prefault a RealTime() SCHED_FIFO thread,
+//   run the same control loop
+// - the loop touches a large stack buffer and builds a status message two ways :
+//   std::string concatenation like the other demos, and snprintf into a stack buffer
+// - reports page faults taken inside the loop and allocator calls counted by the detector
+// - -a aborts on the first allocator call from a real-time thread instead of counting
+// need to run as root (or with rtprio / memlock limits) for SCHED_FIFO and mlockall
+// $ sudo ./rt_memory_demo [-a]
+
+#include "LinuxThread.h"
+#include "RealTimeMemory.h"
+
+#include "SyncLog.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+
+
+static constexpr int kLoops = 1000;
+static constexpr std::size_t kStackBufferBytes = 256 * 1024;
+
+
+struct LoopStats
+{
+    long minor_faults;
+    long major_faults;
+    uint64_t allocations;
+    int64_t max_loop_ns;
+};
+
+
+long thread_faults(bool major)
+{
+    rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return major ? usage.ru_majflt : usage.ru_minflt;
+}
+
+
+// keeps the stack buffer from being optimized away
+void consume(volatile char* buffer, std::size_t size)
+{
+    for (std::size_t offset = 0; offset < size; offset += 4096) buffer[offset] = static_cast<char>(offset);
+}
+
+
+void control_loop(bool string_messages, LoopStats& stats)
+{
+    long minor_start = thread_faults(false);
+    long major_start = thread_faults(true);
+    uint64_t allocations_start = RealTimeMemory::RealTimeAllocations();
+    stats.max_loop_ns = 0;
+
+    for (int loop = 0; loop < kLoops; loop++) {
+
+        auto start = std::chrono::steady_clock::now();
+
+        // deep call frame, first touch faults unless the stack was prefaulted
+        char buffer[kStackBufferBytes];
+        consume(buffer, sizeof(buffer));
+
+        std::size_t length;
+        if (string_messages) {
+            std::string msg = "loop " + std::to_string(loop) + ", cores id = " + std::to_string(sched_getcpu());
+            length = msg.size();
+        } else {
+            char msg[128];
+            length = std::snprintf(msg, sizeof(msg), "loop %d, cores id = %d", loop, sched_getcpu());
+        }
+        buffer[0] = static_cast<char>(length);
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        stats.max_loop_ns = std::max<int64_t>(stats.max_loop_ns, elapsed);
+    }
+
+    stats.minor_faults = thread_faults(false) - minor_start;
+    stats.major_faults = thread_faults(true) - major_start;
+    stats.allocations = RealTimeMemory::RealTimeAllocations() - allocations_start;
+}
+
+
+void run(const char* name, bool realtime, bool string_messages)
+{
+    // each run asks for a larger stack so glibc cannot hand back an already faulted cached one
+    static int run_count{0};
+    std::size_t stack_size = (2 + run_count++) * kStackBufferBytes;
+
+    ThreadAttributes attributes = ThreadAttributes().Policy(SCHED_FIFO).Priority(80).StackSize(stack_size);
+    if (realtime) attributes.RealTime(kStackBufferBytes + 64 * 1024);
+
+    LoopStats stats{};
+    LinuxThread thread([string_messages, &stats]() { control_loop(string_messages, stats); }, attributes);
+    thread.Join();
+
+    std::printf("%-10s %-9s minor faults %5ld  major faults %3ld  rt allocations %6lu  max loop %8.1f us\n",
+        name, string_messages ? "string" : "snprintf", stats.minor_faults, stats.major_faults, stats.allocations,
+        stats.max_loop_ns / 1000.0);
+}
+
+
+int main(int argc, char* argv[])
+{
+    bool abort_mode = (argc > 1 && 0 == std::strcmp(argv[1], "-a"));
+    RealTimeMemory::SetAllocationMode(abort_mode ? RealTimeMemory::AllocationMode::ABORT : RealTimeMemory::AllocationMode::COUNT);
+
+    // before mlockall(MCL_FUTURE), which also populates every later mapping such as new thread stacks
+    run("plain", false, true);
+    run("plain", false, false);
+
+    if (!RealTimeMemory::LockAll()) {
+        std::perror("mlockall");
+    }
+    RealTimeMemory::PrefaultHeap(64 * 1024 * 1024);
+
+    run("realtime", true, false);
+    run("realtime", true, true);
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/StatsRegistry.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o stats_benchmark
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/StatsRegistry.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o stats_benchmark
+
+// false sharing penalty of per thread counters
+// - shared  : every thread increments one std::atomic<uint64_t>
+// - naive   : thread idx increments its own element of a packed std::atomic<uint64_t> array, 8 threads per line
+// - sharded : thread idx increments a StatsRegistry Counter, one cache line per thread
+// - thread idx is pinned to cpu idx modulo the cpu count, thread counts double up to the cpu count
+// $ ./stats_benchmark [increments per thread]
+
+#include "LinuxThread.h"
+#include "StatsRegistry.h"
+#include "SyncLog.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+static constexpr unsigned int kMaxThreads = 256;
+
+static std::atomic<uint64_t> shared_counter{0};
+static std::atomic<uint64_t> naive_counters[kMaxThreads];
+
+
+// start every thread together, returns ns per increment averaged over the threads
+template <typename Func>
+double run(unsigned int num_threads, uint64_t increments, Func increment)
+{
+    unsigned int cpus = std::thread::hardware_concurrency();
+    std::atomic<unsigned int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<double> elapsed_ns(num_threads);
+
+    {
+        std::vector<std::unique_ptr<LinuxThread>> threads;
+        for (unsigned int idx = 0; idx < num_threads; idx++) {
+            threads.push_back(std::make_unique<LinuxThread>([&, idx]() {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+                auto start = std::chrono::steady_clock::now();
+                for (uint64_t i = 0; i < increments; i++) increment(idx);
+                elapsed_ns[idx] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            }, idx % cpus));
+        }
+        while (ready.load() < num_threads) std::this_thread::yield();
+        go.store(true, std::memory_order_release);
+    }
+
+    double sum{0};
+    for (double ns : elapsed_ns) sum += ns;
+    return sum / num_threads / increments;
+}
+
+
+int main(int argc, char* argv[])
+{
+    uint64_t increments = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    unsigned int cpus = std::thread::hardware_concurrency();
+    unsigned int max_threads = std::min(kMaxThreads, std::max(cpus, 2u));
+
+    Counter& sharded_counter = StatsRegistry::GetRegistry()->GetCounter("benchmark.increments");
+    Gauge& threads_gauge = StatsRegistry::GetRegistry()->GetGauge("benchmark.threads");
+
+    std::printf("%lu increments per thread, %u cpus\n", increments, cpus);
+    std::printf("%8s %14s %14s %14s   (ns per increment)\n", "threads", "shared", "naive", "sharded");
+
+    for (unsigned int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+
+        double shared_ns = run(num_threads, increments, [](unsigned int) {
+            shared_counter.fetch_add(1, std::memory_order_relaxed);
+        });
+
+        double naive_ns = run(num_threads, increments, [](unsigned int idx) {
+            naive_counters[idx].fetch_add(1, std::memory_order_relaxed);
+        });
+
+        sharded_counter.Reset();
+        double sharded_ns = run(num_threads, increments, [&sharded_counter](unsigned int) {
+            sharded_counter.Add();
+        });
+        threads_gauge.Set(num_threads);
+
+        if (sharded_counter.Read() != num_threads * increments) {
+            std::printf("sharded counter lost increments : %lu\n", sharded_counter.Read());
+            return 1;
+        }
+
+        std::printf("%8u %14.2f %14.2f %14.2f\n", num_threads, shared_ns, naive_ns, sharded_ns);
+    }
+
+    StatsRegistry::GetRegistry()->Report();
+
+    return 0;
+}
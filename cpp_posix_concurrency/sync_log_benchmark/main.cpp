@@ -0,0 +1,117 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/SyncLog.cpp -o sync_log_benchmark
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/SyncLog.cpp -o sync_log_benchmark
+
+// SyncLog mutex path vs async ring path vs typed SYNC_LOG() records as the number of logging threads grows
+// - mutex and async modes build the message with std::string / std::to_string per call like the demos do
+// - log output goes to the sink (default /dev/null), the report goes to the original stdout
+// - msgs/sec counts delivered messages only (dropped ones are reported apart), async runs include the final
+//   drain of the rings
+// $ ./sync_log_benchmark [messages per thread] [sink]
+
+#include "SyncLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+
+enum class Mode {
+    MUTEX,
+    ASYNC,
+    TYPED
+};
+
+
+struct RunResult
+{
+    double msgs_per_sec;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t overflows;
+};
+
+
+RunResult run(unsigned int num_threads, int messages, Mode mode)
+{
+    std::vector<std::vector<uint64_t>> latencies(num_threads, std::vector<uint64_t>(messages));
+    std::vector<std::thread> threads;
+
+    bool async = (Mode::MUTEX != mode);
+    if (async) SyncLog::GetLog()->StartAsync(4096);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned int thread_idx = 0; thread_idx < num_threads; thread_idx++) {
+        threads.emplace_back([thread_idx, messages, mode, &latencies]() {
+            for (int msg_idx = 0; msg_idx < messages; msg_idx++) {
+                auto before = std::chrono::steady_clock::now();
+                if (Mode::TYPED == mode) {
+                    SYNC_LOG("thread {} benchmark message {} with some payload", thread_idx, msg_idx);
+                } else {
+                    SyncLog::GetLog()->Log("thread " + std::to_string(thread_idx) + " benchmark message "
+                        + std::to_string(msg_idx) + " with some payload");
+                }
+                auto after = std::chrono::steady_clock::now();
+                latencies[thread_idx][msg_idx] = std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count();
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    // the run ends once the drainer has written everything out
+    RunResult result{};
+    if (async) {
+        SyncLog::GetLog()->StopAsync();
+        result.overflows = SyncLog::GetLog()->Overflows();
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<uint64_t> all;
+    for (auto& thread_latencies : latencies) all.insert(all.end(), thread_latencies.begin(), thread_latencies.end());
+    std::sort(all.begin(), all.end());
+
+    // dropped messages cost a call but were never delivered
+    result.msgs_per_sec = (all.size() - result.overflows) / elapsed;
+    result.p50_ns = all[all.size() / 2];
+    result.p99_ns = all[all.size() * 99 / 100];
+    return result;
+}
+
+
+int main(int argc, char* argv[])
+{
+    int messages = (argc > 1) ? std::atoi(argv[1]) : 100000;
+    const char* sink = (argc > 2) ? argv[2] : "/dev/null";
+
+    // keep the report on the terminal, send the log traffic to the sink
+    FILE* report = fdopen(dup(STDOUT_FILENO), "w");
+    int sink_fd = open(sink, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (sink_fd < 0) {
+        std::fprintf(stderr, "failed to open sink %s\n", sink);
+        return 1;
+    }
+    dup2(sink_fd, STDOUT_FILENO);
+
+    unsigned int max_threads = std::max(2u, 2 * std::thread::hardware_concurrency());
+
+    std::fprintf(report, "%-8s %-6s %14s %10s %10s %10s\n", "threads", "mode", "msgs/sec", "p50(ns)", "p99(ns)", "dropped");
+    for (unsigned int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        for (Mode mode : {Mode::MUTEX, Mode::ASYNC, Mode::TYPED}) {
+            RunResult result = run(num_threads, messages, mode);
+            std::fprintf(report, "%-8u %-6s %14.0f %10lu %10lu %10lu\n", num_threads,
+                (Mode::MUTEX == mode) ? "mutex" : (Mode::ASYNC == mode) ? "async" : "typed",
+                result.msgs_per_sec, result.p50_ns, result.p99_ns, result.overflows);
+            std::fflush(report);
+        }
+    }
+
+    return 0;
+}
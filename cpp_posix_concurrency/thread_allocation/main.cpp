@@ -1,14 +1,15 @@
 // compiler options
-// $ g++ -g -O0 -std=c++17 -I../util -pthread -ggdb -lpthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp -o allocation_demo
-// $ clang++ -g -O0 -std=c++17 -pthread -lpthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp -o allocation_demo
+// $ g++ -g -O0 -std=c++17 -I../util -pthread -ggdb -lpthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp ../util/SchedSampler.cpp -o allocation_demo
+// $ clang++ -g -O0 -std=c++17 -pthread -lpthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp ../util/SchedSampler.cpp -o allocation_demo
 
 // simple demo of thread collection construct destruct
 
+#include "CpuTopology.h"
 #include "LinuxThread.h"
+#include "SchedSampler.h"
 
 #include "SyncLog.h"
 
-#include <sstream>
 #include <sys/resource.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
@@ -34,19 +35,17 @@ void thread_handler(std::string name)
             tid = syscall(SYS_gettid);
             int priority = getpriority(PRIO_PROCESS, tid);
 
-            SyncLog::GetLog()->Log("thread " + name + ", id = " + std::to_string(tid) + ", priority = " + std::to_string(priority)
-                + ", policy = " + std::string(((policy == SCHED_OTHER)  ? "SCHED_OTHER" :
-                    (policy == SCHED_BATCH) ? "SCHED_RR" :
-                    "SCHED_IDLE")));
+            SYNC_LOG("thread {}, id = {}, priority = {}, policy = {}", name, tid, priority,
+                ((policy == SCHED_OTHER)  ? "SCHED_OTHER" :
+                    (policy == SCHED_BATCH) ? "SCHED_BATCH" :
+                    "SCHED_IDLE"));
         } else {
 
-            std::stringstream ss;
-            ss << std::this_thread::get_id();
-            SyncLog::GetLog()->Log("thread " + name + ", id = " + ss.str() + ", priority = " + std::to_string(sch.sched_priority) 
-                + ", policy = " + std::string(((policy == SCHED_FIFO)  ? "SCHED_FIFO" :
+            SYNC_LOG("thread {}, id = {}, priority = {}, policy = {}", name, pthread_self(), sch.sched_priority,
+                ((policy == SCHED_FIFO)  ? "SCHED_FIFO" :
                     (policy == SCHED_RR)    ? "SCHED_RR" :
                     (policy == SCHED_OTHER) ? "SCHED_OTHER" :
-                    "???")));
+                    "???"));
         }
 
         std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -58,14 +57,30 @@ void thread_handler(std::string name)
 int main() 
 {
     // number of concurrenty threads platform supports ( $ cat /proc/cpuinfo )
-    auto num_cores = std::thread::hardware_concurrency();
+    std::cout << "hardware_concurrency() : " << std::thread::hardware_concurrency() << std::endl;
 
-    std::cout << "hardware_concurrency() : " << num_cores << std::endl;
+    // what this process may use : affinity mask, cgroup cpuset and cpu.max quota
+    auto num_cores = CpuTopology::EffectiveConcurrency();
+    cpu_set_t effective_cpus = CpuTopology::EffectiveCpus();
+    std::cout << "EffectiveConcurrency() : " << num_cores << ", cpus : " << CpuTopology::FormatCpuList(effective_cpus)
+        << ", cpu.max quota : " << CpuTopology::CpuQuota() << std::endl;
+
+    // run queue delay, switches and migrations of every thread, logged each second
+    SchedSampler sampler(std::chrono::seconds(1));
 
     std::vector<LinuxThread> linux_threads;
-    for (int idx = 0; idx < num_cores; idx++) {
+    for (unsigned int idx = 0; idx < num_cores; idx++) {
         // uses move constructor
-        linux_threads.push_back(LinuxThread(thread_handler, "thread_" + std::to_string(idx), SCHED_OTHER, idx));
+        linux_threads.push_back(LinuxThread(thread_handler, "thread_" + std::to_string(idx), CpuTopology::EffectiveCpu(idx)));
+    }
+
+    // programmatic view of the same numbers, mid run
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    for (auto& thread_elem : linux_threads) {
+        SchedSampler::ThreadSched sched;
+        if (sampler.LastInterval(thread_elem.Tid(), sched)) {
+            SYNC_LOG("tid {} waited {} us runnable over the last interval", sched.tid, sched.wait_ns / 1000);
+        }
     }
 
     for (auto& thread_elem : linux_threads) thread_elem.Join();
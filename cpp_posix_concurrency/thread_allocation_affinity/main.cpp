@@ -1,9 +1,10 @@
 // compiler options
-// $ g++ -g -O0 -std=c++17 -I../util -pthread -ggdb -lpthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp -o allocation__affinity_demo
-// $ clang++ -g -O0 -std=c++17 -I../util -pthread -lpthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp -o allocation_affinity_demo
+// $ g++ -g -O0 -std=c++17 -I../util -pthread -ggdb -lpthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o allocation__affinity_demo
+// $ clang++ -g -O0 -std=c++17 -I../util -pthread -lpthread main.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o allocation_affinity_demo
 
 // simple demo of affinity assigned thread collection construct destruct
 
+#include "CpuTopology.h"
 #include "LinuxThread.h"
 
 #include "SyncLog.h"
@@ -64,48 +65,11 @@ void thread_handler(std::string name)
     }
 }
 
-void thread_handler_priority(std::string name, int policy, int priority)
+// policy, niceness and affinity are applied by LinuxThread before this runs, the thread only reports them
+void thread_handler_priority(std::string name)
 {
     sched_param scheduler_params;
-    int current_policy; 
-
-    // configure priority/niceness
-    pthread_getschedparam(pthread_self(), &current_policy, &scheduler_params);
-
-    if (SCHED_OTHER == policy || SCHED_BATCH == policy || SCHED_IDLE == policy) {
-
-        SyncLog::GetLog()->Log("current policy[CFS] : " + std::string(((SCHED_OTHER == current_policy) ? "SCHED_OTHER" :
-                (SCHED_BATCH == policy) ? "SCHED_BATCH" :
-                    "SCHED_IDLE")));
-
-        /* set policy */
-        if (0 == pthread_setschedparam(pthread_self(), policy, &scheduler_params)) {
-            SyncLog::GetLog()->Log("policy[REALTIME] : " + std::string(((policy == SCHED_FIFO)  ? "SCHED_FIFO" :
-                (policy == SCHED_RR)    ? "SCHED_RR" :
-                "SCHED_OTHER")));
-        } else {
-            std::cerr << "Failed to set Thread scheduling : " << std::strerror(errno) << std::endl;
-        }
-
-        pid_t tid;
-        tid = syscall(SYS_gettid);
-        /* set niceness */
-        if (-1 == setpriority(PRIO_PROCESS, tid, priority)) {
-            SyncLog::GetLog()->Log(("setpriority() failure"));
-        }
-    
-    } else {
-
-        /* set priority */
-        scheduler_params.sched_priority = priority;
-        if (0 == pthread_setschedparam(pthread_self(), policy, &scheduler_params)) {
-             SyncLog::GetLog()->Log(("policy[REALTIME] : " + std::string(((policy == SCHED_FIFO)  ? "SCHED_FIFO" :
-                (policy == SCHED_RR)    ? "SCHED_RR" :
-                "SCHED_OTHER"))));
-        } else {
-            std::cerr << "Failed to set Thread scheduling : " << std::strerror(errno) << std::endl;
-        }
-    }
+    int policy;
 
     int run_count{0};
     bool running{true};
@@ -120,10 +84,11 @@ void thread_handler_priority(std::string name, int policy, int priority)
             tid = syscall(SYS_gettid);
             int niceness = getpriority(PRIO_PROCESS, tid);
 
-            SyncLog::GetLog()->Log("thread " + name + ", id = " + std::to_string(tid) + ", niceness = " + std::to_string(niceness)
-                + ", policy = " + std::string(((current_policy == SCHED_OTHER)  ? "SCHED_OTHER" :
-                    (current_policy == SCHED_BATCH)    ? "SCHED_BATCH" :
-                    (current_policy == SCHED_IDLE) ? "SCHED_IDLE" :
+            SyncLog::GetLog()->Log("thread " + name + ", id = " + std::to_string(tid) + ", cores id = " + std::to_string(sched_getcpu())
+                + ", niceness = " + std::to_string(niceness)
+                + ", policy = " + std::string(((policy == SCHED_OTHER)  ? "SCHED_OTHER" :
+                    (policy == SCHED_BATCH)    ? "SCHED_BATCH" :
+                    (policy == SCHED_IDLE) ? "SCHED_IDLE" :
                     "???")));
         } else {
 
@@ -144,17 +109,39 @@ void thread_handler_priority(std::string name, int policy, int priority)
 int main() 
 {
     // number of concurrenty threads platform supports ( $ cat /proc/cpuinfo )
-    auto num_cores = std::thread::hardware_concurrency();
+    std::cout << "hardware_concurrency() : " << std::thread::hardware_concurrency() << std::endl;
+
+    // what this process may use : affinity mask, cgroup cpuset and cpu.max quota
+    auto num_cores = CpuTopology::EffectiveConcurrency();
+    std::cout << "EffectiveConcurrency() : " << num_cores << ", cpu.max quota : " << CpuTopology::CpuQuota() << std::endl;
 
-    std::cout << "hardware_concurrency() : " << num_cores << std::endl;
+    // spread over physical cores and cache domains rather than thread idx == cpu idx
+    CpuTopology topology = CpuTopology::Load();
+    std::cout << "physical cores : " << topology.PhysicalCores() << ", llc domains : " << topology.LlcDomains() << std::endl;
+    std::vector<cpu_set_t> placement = topology.Place(CpuTopology::Placement::SPREAD_CORES, num_cores);
 
     std::vector<LinuxThread> linux_threads;
-    for (int idx = 0; idx < num_cores; idx++) {
+    for (unsigned int idx = 0; idx < num_cores; idx++) {
+        std::cout << "thread_" << idx << " cpus : " << CpuTopology::FormatCpuList(placement[idx]) << std::endl;
         // uses move constructor
-        linux_threads.push_back(LinuxThread(thread_handler_priority, "thread_" + std::to_string(idx), SCHED_OTHER, idx, idx));
+        ThreadAttributes attributes = ThreadAttributes().Policy(SCHED_OTHER).Nice(idx).Affinity(placement[idx]).PerfCounters();
+        linux_threads.push_back(LinuxThread(thread_handler_priority, "thread_" + std::to_string(idx), attributes));
     }
 
     for (auto& thread_elem : linux_threads) thread_elem.Join();
 
+    // did the placement pay off : migrations and context switches should stay low for pinned threads
+    for (std::size_t idx = 0; idx < linux_threads.size(); idx++) {
+        ThreadCounters counters = linux_threads[idx].ThreadInfo();
+        std::cout << "thread_" << idx
+            << " cycles : " << counters.cycles
+            << ", instructions : " << counters.instructions
+            << ", ipc : " << counters.Ipc()
+            << ", cache misses : " << counters.cache_misses
+            << ", context switches : " << counters.context_switches
+            << ", cpu migrations : " << counters.cpu_migrations
+            << ", page faults : " << counters.page_faults << std::endl;
+    }
+
     return 0;
 }
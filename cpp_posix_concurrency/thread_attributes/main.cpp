@@ -0,0 +1,138 @@
+// compiler options
+// $ g++ -g -O0 -std=c++17 -I../util -pthread -ggdb -lpthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o attributes_demo
+// $ clang++ -g -O0 -std=c++17 -I../util -pthread -lpthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o attributes_demo
+
+// self checking demo of pre-start thread attributes
+// - the first thing each thread does is sample its cpu, policy, priority, niceness and stack
+// - every sample must already match the requested ThreadAttributes, exit status is non zero otherwise
+// - SCHED_FIFO / SCHED_RR cases need root or an rtprio limit ( $ ulimit -r ), they are skipped without
+
+#include "LinuxThread.h"
+
+#include "SyncLog.h"
+
+#include <cstdio>
+#include <sched.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+
+struct FirstSample
+{
+    int cpu;
+    int policy;
+    int priority;
+    int niceness;
+    size_t stack_size;
+    size_t guard_size;
+};
+
+
+struct TestCase
+{
+    std::string name;
+    int policy;
+    int priority;
+    int niceness;
+    size_t stack_size;
+    size_t guard_size;
+};
+
+
+const char* policy_name(int policy)
+{
+    return (policy == SCHED_OTHER) ? "SCHED_OTHER" :
+        (policy == SCHED_BATCH) ? "SCHED_BATCH" :
+        (policy == SCHED_IDLE) ? "SCHED_IDLE" :
+        (policy == SCHED_FIFO) ? "SCHED_FIFO" :
+        (policy == SCHED_RR) ? "SCHED_RR" :
+        "???";
+}
+
+
+void sample(FirstSample& first)
+{
+    // nothing ahead of this
+    first.cpu = sched_getcpu();
+    first.policy = sched_getscheduler(0);
+    sched_param scheduler_params;
+    sched_getparam(0, &scheduler_params);
+    first.priority = scheduler_params.sched_priority;
+    first.niceness = getpriority(PRIO_PROCESS, syscall(SYS_gettid));
+
+    pthread_attr_t attr;
+    pthread_getattr_np(pthread_self(), &attr);
+    pthread_attr_getstacksize(&attr, &first.stack_size);
+    pthread_attr_getguardsize(&attr, &first.guard_size);
+    pthread_attr_destroy(&attr);
+}
+
+
+bool realtime_permitted()
+{
+    rlimit rtprio;
+    return 0 == geteuid() || (0 == getrlimit(RLIMIT_RTPRIO, &rtprio) && rtprio.rlim_cur > 0);
+}
+
+
+int main()
+{
+    // pin to the last cpu we may use, the creating thread normally runs elsewhere
+    cpu_set_t allowed;
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    int target_cpu = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) if (CPU_ISSET(cpu, &allowed)) target_cpu = cpu;
+
+    std::vector<TestCase> cases = {
+        {"other_nice", SCHED_OTHER, 0, 5, 0, 0},
+        {"batch", SCHED_BATCH, 0, 10, 0, 0},
+        {"idle", SCHED_IDLE, 0, 0, 0, 0},
+        {"other_stack", SCHED_OTHER, 0, 0, 256 * 1024, 64 * 1024},
+        {"fifo", SCHED_FIFO, 10, 0, 0, 0},
+        {"rr", SCHED_RR, 20, 0, 0, 0},
+    };
+
+    int failures{0};
+
+    for (auto& test : cases) {
+
+        bool realtime = (SCHED_FIFO == test.policy || SCHED_RR == test.policy);
+        if (realtime && !realtime_permitted()) {
+            std::printf("SKIP %-12s %s needs rtprio privileges\n", test.name.c_str(), policy_name(test.policy));
+            continue;
+        }
+
+        ThreadAttributes attributes = ThreadAttributes().Policy(test.policy).Affinity(target_cpu);
+        if (realtime) attributes.Priority(test.priority);
+        if (test.niceness) attributes.Nice(test.niceness);
+        if (test.stack_size) attributes.StackSize(test.stack_size);
+        if (test.guard_size) attributes.GuardSize(test.guard_size);
+
+        FirstSample first{};
+        {
+            LinuxThread thread([&first]() { sample(first); }, attributes);
+            thread.Join();
+        }
+
+        bool pass = first.cpu == target_cpu
+            && first.policy == test.policy
+            && first.priority == test.priority
+            && first.niceness == test.niceness
+            && (!test.stack_size || first.stack_size == test.stack_size)
+            && (!test.guard_size || first.guard_size == test.guard_size);
+        if (!pass) failures++;
+
+        std::printf("%s %-12s cpu %d/%d, policy %s/%s, priority %d/%d, niceness %d/%d, stack %zu, guard %zu\n",
+            pass ? "PASS" : "FAIL", test.name.c_str(),
+            first.cpu, target_cpu,
+            policy_name(first.policy), policy_name(test.policy),
+            first.priority, test.priority,
+            first.niceness, test.niceness,
+            first.stack_size, first.guard_size);
+    }
+
+    return failures ? 1 : 0;
+}
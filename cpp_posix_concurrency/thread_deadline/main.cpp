@@ -0,0 +1,174 @@
+// compiler options
+// $ g++ -g -O2 -std=c++17 -I../util -pthread -ggdb -lpthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o deadline_demo
+// $ clang++ -g -O2 -std=c++17 -I../util -pthread -lpthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o deadline_demo
+
+// SCHED_DEADLINE vs SCHED_FIFO for the same periodic job
+// - each job burns work_us of cpu once per period_us
+// - SCHED_DEADLINE : runtime / deadline / period reservation, the job ends with sched_yield()
+// - SCHED_FIFO : absolute clock_nanosleep() to the next period boundary
+// - reports start jitter against the ideal period grid, cpu utilization and deadline overruns
+// - every overrun_every-th job runs long (-o) to provoke overruns of the deadline runtime
+// need to run as root
+// $ sudo ./deadline_demo [-p period_us] [-w work_us] [-r runtime_us] [-l loops] [-o overrun_every]
+
+#include "LinuxThread.h"
+
+#include "SyncLog.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+
+struct Options
+{
+    long period_us{10000};
+    long work_us{2000};
+    long runtime_us{3000};
+    long loops{500};
+    long overrun_every{0};
+};
+
+
+struct JobStats
+{
+    int64_t min_jitter_ns{INT64_MAX};
+    int64_t max_jitter_ns{0};
+    int64_t sum_jitter_ns{0};
+    long jobs{0};
+    double cpu_seconds{0};
+    double wall_seconds{0};
+};
+
+
+int64_t now_ns(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+void burn(long work_us)
+{
+    int64_t start = now_ns(CLOCK_THREAD_CPUTIME_ID);
+    while (now_ns(CLOCK_THREAD_CPUTIME_ID) - start < work_us * 1000) {}
+}
+
+
+void record(JobStats& stats, int64_t jitter_ns)
+{
+    jitter_ns = std::abs(jitter_ns);
+    stats.min_jitter_ns = std::min(stats.min_jitter_ns, jitter_ns);
+    stats.max_jitter_ns = std::max(stats.max_jitter_ns, jitter_ns);
+    stats.sum_jitter_ns += jitter_ns;
+    stats.jobs++;
+}
+
+
+long job_work(const Options& options, long loop)
+{
+    bool overrun = options.overrun_every && 0 == (loop + 1) % options.overrun_every;
+    return overrun ? 2 * options.runtime_us : options.work_us;
+}
+
+
+void deadline_handler(const Options& options, JobStats& stats)
+{
+    int64_t period_ns = options.period_us * 1000;
+    int64_t cpu_start = now_ns(CLOCK_THREAD_CPUTIME_ID);
+    // the reservation starts with the first job
+    int64_t origin = now_ns(CLOCK_MONOTONIC);
+
+    for (long loop = 0; loop < options.loops; loop++) {
+        int64_t start = now_ns(CLOCK_MONOTONIC);
+        // jobs released after an overrun slip, measure against the closest grid point
+        int64_t offset = (start - origin) % period_ns;
+        record(stats, std::min(offset, period_ns - offset));
+        burn(job_work(options, loop));
+        LinuxThread::Yield();
+    }
+
+    stats.cpu_seconds = (now_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start) / 1e9;
+    stats.wall_seconds = (now_ns(CLOCK_MONOTONIC) - origin) / 1e9;
+}
+
+
+void fifo_handler(const Options& options, JobStats& stats)
+{
+    int64_t period_ns = options.period_us * 1000;
+    int64_t cpu_start = now_ns(CLOCK_THREAD_CPUTIME_ID);
+    int64_t origin = now_ns(CLOCK_MONOTONIC);
+    int64_t next = origin;
+
+    for (long loop = 0; loop < options.loops; loop++) {
+        int64_t start = now_ns(CLOCK_MONOTONIC);
+        record(stats, start - next);
+        burn(job_work(options, loop));
+
+        next += period_ns;
+        timespec deadline{static_cast<time_t>(next / 1000000000), static_cast<long>(next % 1000000000)};
+        while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr)) {}
+    }
+
+    stats.cpu_seconds = (now_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start) / 1e9;
+    stats.wall_seconds = (now_ns(CLOCK_MONOTONIC) - origin) / 1e9;
+}
+
+
+void report(const char* name, const JobStats& stats, uint64_t overruns)
+{
+    std::printf("%-15s jobs %5ld  jitter min %8.1f avg %8.1f max %8.1f us  cpu %5.1f %%  overruns %lu\n",
+        name, stats.jobs,
+        stats.min_jitter_ns / 1000.0,
+        stats.sum_jitter_ns / 1000.0 / std::max(1L, stats.jobs),
+        stats.max_jitter_ns / 1000.0,
+        100.0 * stats.cpu_seconds / std::max(1e-9, stats.wall_seconds),
+        overruns);
+}
+
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "p:w:r:l:o:"))) {
+        switch (opt) {
+            case 'p': options.period_us = std::atol(optarg); break;
+            case 'w': options.work_us = std::atol(optarg); break;
+            case 'r': options.runtime_us = std::atol(optarg); break;
+            case 'l': options.loops = std::atol(optarg); break;
+            case 'o': options.overrun_every = std::atol(optarg); break;
+            default:
+                std::fprintf(stderr, "usage : %s [-p period_us] [-w work_us] [-r runtime_us] [-l loops] [-o overrun_every]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    std::printf("period %ld us, work %ld us, deadline runtime %ld us, %ld jobs\n",
+        options.period_us, options.work_us, options.runtime_us, options.loops);
+
+    {
+        JobStats stats;
+        uint64_t period_ns = options.period_us * 1000;
+        LinuxThread thread([&options, &stats]() { deadline_handler(options, stats); },
+            ThreadAttributes().Deadline(options.runtime_us * 1000, period_ns, period_ns));
+        thread.Join();
+        // overruns taken by another thread are only visible process wide
+        report("SCHED_DEADLINE", stats, thread.DeadlineOverruns() + LinuxThread::StraySigxcpu());
+    }
+
+    {
+        JobStats stats;
+        LinuxThread thread([&options, &stats]() { fifo_handler(options, stats); },
+            ThreadAttributes().Policy(SCHED_FIFO).Priority(80));
+        thread.Join();
+        report("SCHED_FIFO", stats, 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,219 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/ThreadPool.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o thread_pool_benchmark
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/ThreadPool.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o thread_pool_benchmark
+
+// fine grained task benchmark : work stealing ThreadPool vs std::async vs a single shared mutex queue
+// - fork / join fibonacci, one task per fork above the cutoff
+// - parallel sum by recursive halving down to a grain
+// $ ./thread_pool_benchmark [fib n] [sum elements]
+
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+
+static constexpr int kFibCutoff = 12;
+static constexpr std::size_t kSumGrain = 16 * 1024;
+
+
+// baseline executor : all workers share one mutex protected queue
+class MutexQueuePool
+{
+
+public:
+
+    explicit MutexQueuePool(unsigned int num_workers)
+    {
+        for (unsigned int idx = 0; idx < num_workers; idx++) {
+            threads_.emplace_back([this]() {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lck (mtx_);
+                        cv_.wait(lck, [this] { return stopping_ || !tasks_.empty(); });
+                        if (tasks_.empty()) return;
+                        task = std::move(tasks_.front());
+                        tasks_.pop_front();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    ~MutexQueuePool()
+    {
+        {
+            std::lock_guard<std::mutex> lck (mtx_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& thread : threads_) thread.join();
+    }
+
+    void Submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lck (mtx_);
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+    bool TryRunOne()
+    {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lck (mtx_);
+            if (tasks_.empty()) return false;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+        return true;
+    }
+
+private:
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_{false};
+    std::vector<std::thread> threads_;
+};
+
+
+// TaskGroup equivalent for the baseline
+class MutexTaskGroup
+{
+
+public:
+
+    explicit MutexTaskGroup(MutexQueuePool& pool) : pool_(pool) {}
+
+    void Run(std::function<void()> task)
+    {
+        pending_.fetch_add(1);
+        pool_.Submit([this, task = std::move(task)]() {
+            task();
+            pending_.fetch_sub(1);
+        });
+    }
+
+    void Wait()
+    {
+        while (pending_.load() > 0) {
+            if (!pool_.TryRunOne()) std::this_thread::yield();
+        }
+    }
+
+private:
+
+    MutexQueuePool& pool_;
+    std::atomic<int> pending_{0};
+};
+
+
+uint64_t fib_serial(int n)
+{
+    return (n < 2) ? n : fib_serial(n - 1) + fib_serial(n - 2);
+}
+
+
+template <typename Pool, typename Group>
+uint64_t fib_fork(Pool& pool, int n)
+{
+    if (n < kFibCutoff) return fib_serial(n);
+
+    uint64_t left{0};
+    Group group(pool);
+    group.Run([&pool, &left, n]() { left = fib_fork<Pool, Group>(pool, n - 1); });
+    uint64_t right = fib_fork<Pool, Group>(pool, n - 2);
+    group.Wait();
+    return left + right;
+}
+
+
+uint64_t fib_async(int n)
+{
+    if (n < kFibCutoff) return fib_serial(n);
+
+    auto left = std::async(std::launch::async, fib_async, n - 1);
+    uint64_t right = fib_async(n - 2);
+    return left.get() + right;
+}
+
+
+template <typename Pool, typename Group>
+uint64_t sum_fork(Pool& pool, const uint64_t* data, std::size_t count)
+{
+    if (count <= kSumGrain) return std::accumulate(data, data + count, uint64_t{0});
+
+    uint64_t left{0};
+    Group group(pool);
+    group.Run([&pool, &left, data, count]() { left = sum_fork<Pool, Group>(pool, data, count / 2); });
+    uint64_t right = sum_fork<Pool, Group>(pool, data + count / 2, count - count / 2);
+    group.Wait();
+    return left + right;
+}
+
+
+uint64_t sum_async(const uint64_t* data, std::size_t count)
+{
+    if (count <= kSumGrain) return std::accumulate(data, data + count, uint64_t{0});
+
+    auto left = std::async(std::launch::async, sum_async, data, count / 2);
+    uint64_t right = sum_async(data + count / 2, count - count / 2);
+    return left.get() + right;
+}
+
+
+template <typename Func>
+void report(const char* benchmark, const char* executor, Func func)
+{
+    auto start = std::chrono::steady_clock::now();
+    uint64_t result = func();
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-6s %-14s %12.2f ms   result = %lu\n", benchmark, executor, elapsed_ms, result);
+}
+
+
+int main(int argc, char* argv[])
+{
+    int fib_n = (argc > 1) ? std::atoi(argv[1]) : 30;
+    std::size_t sum_elements = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 32 * 1024 * 1024;
+
+    unsigned int num_workers = CpuTopology::EffectiveConcurrency();
+    std::printf("workers : %u, fib(%d) cutoff %d, sum of %zu elements grain %zu\n",
+        num_workers, fib_n, kFibCutoff, sum_elements, kSumGrain);
+
+    std::vector<uint64_t> data(sum_elements);
+    std::iota(data.begin(), data.end(), 0);
+
+    {
+        ThreadPool pool(num_workers);
+        report("fib", "work_stealing", [&]() { return fib_fork<ThreadPool, TaskGroup>(pool, fib_n); });
+        report("sum", "work_stealing", [&]() { return sum_fork<ThreadPool, TaskGroup>(pool, data.data(), data.size()); });
+    }
+
+    {
+        MutexQueuePool pool(num_workers);
+        report("fib", "mutex_queue", [&]() { return fib_fork<MutexQueuePool, MutexTaskGroup>(pool, fib_n); });
+        report("sum", "mutex_queue", [&]() { return sum_fork<MutexQueuePool, MutexTaskGroup>(pool, data.data(), data.size()); });
+    }
+
+    report("fib", "std::async", [&]() { return fib_async(fib_n); });
+    report("sum", "std::async", [&]() { return sum_async(data.data(), data.size()); });
+
+    return 0;
+}
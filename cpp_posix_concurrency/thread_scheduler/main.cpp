@@ -1,8 +1,12 @@
 // compiler options
-// $ g++ -g -O0 -std=c++17 -pthread -ggdb -lpthread -o scheduler_demo main.cpp
-// $ clang++ -g -O0 -std=c++17 -pthread -lpthread main.cpp -o scheduler_demo
+// $ g++ -g -O2 -std=c++17 -I../util -pthread -ggdb -lpthread -o scheduler_demo main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp
+// $ clang++ -g -O2 -std=c++17 -I../util -pthread -lpthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o scheduler_demo
 
-// simple demo of CFS and realtime linux threading
+// cyclictest style wakeup latency of CFS and realtime linux threading
+// - one measurement thread per policy sleeps to absolute period boundaries with clock_nanosleep(TIMER_ABSTIME)
+//   and records how late each wakeup is into a histogram
+// - optional SCHED_OTHER cpu hogs share the measurement cpu to show how each policy holds up under contention
+// $ ./scheduler_demo [-i interval_us] [-l loops] [-H hogs] [-c cpu] [-p rt_priority]
 
 // ulimit shows user limits ... for real time priority limits
 // $ ulimit -r
@@ -11,18 +15,23 @@
 // /etc/security/limits.conf can also be edited to increase a groups realtime priority setting level
 // @group - rtprio 65
 
+#include "LinuxThread.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <errno.h>
-#include <functional>
+#include <iomanip>
 #include <iostream>
 #include <mutex>
 #include <sstream>
 #include <string.h>
 #include <sys/resource.h>
-#include <sys/syscall.h>
-#include <sys/types.h>
-#include <thread>
+#include <time.h>
 #include <unistd.h>
+#include <vector>
 
 using namespace std;
 
@@ -36,206 +45,205 @@ void log(std::string msg)
 }
 
 
-class LinuxThread
-{
+// 1 us buckets, wakeups later than the last bucket are counted as overflows
+static constexpr int kHistogramUs = 10000;
 
-public:
-
-    // Delete the copy constructor
-    LinuxThread(const LinuxThread&) = delete;
- 
-    // Delete the Assignment opeartor
-    LinuxThread& operator=(const LinuxThread&) = delete;
- 
-    // Parameterized Constructor
-    LinuxThread(std::function<void()> func) : thread_(func)
-    {}
-
-    // Parameterized Constructor
-    LinuxThread(std::function<void(std::string, int, int)> func, std::string name, int policy, int priority) :
-        name_(name),
-        thread_(func, name, policy, priority)
+struct LatencyHistogram
+{
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(kHistogramUs, 0);
+    uint64_t overflows{0};
+    uint64_t samples{0};
+    int64_t min_ns{INT64_MAX};
+    int64_t max_ns{0};
+    int64_t sum_ns{0};
+
+    void Add(int64_t latency_ns)
     {
-        sched_param scheduler_params;
-        int current_policy; 
-
-        pthread_getschedparam(thread_.native_handle(), &current_policy, &scheduler_params);
-        if (SCHED_OTHER == policy || SCHED_BATCH == policy || SCHED_IDLE == policy) {
-
-            log("policy[CFS] : " + std::string(((SCHED_OTHER == policy) ? "SCHED_OTHER" :
-                (SCHED_BATCH == policy) ? "SCHED_BATCH" :
-                 "SCHED_IDLE")));
-
-            pid_t tid;
-            tid = syscall(SYS_gettid);
-            if (-1 == setpriority(PRIO_PROCESS, tid, priority)) {
-                log("setpriority() failure");
-            }
-
+        int64_t latency_us = latency_ns / 1000;
+        if (latency_us < kHistogramUs) {
+            buckets[latency_us]++;
         } else {
-
-            scheduler_params.sched_priority = priority;
-            if (0 == pthread_setschedparam(thread_.native_handle(), policy, &scheduler_params)) {
-                log("policy[REALTIME] : " + std::string(((policy == SCHED_FIFO)  ? "SCHED_FIFO" :
-                   (policy == SCHED_RR)    ? "SCHED_RR" :
-                   "SCHED_OTHER")));
-            } else {
-                std::cerr << "Failed to set Thread scheduling : " << std::strerror(errno) << std::endl;
-            }
+            overflows++;
         }
-    }
- 
-    // Move Constructor
-    LinuxThread(LinuxThread && obj) : thread_(std::move(obj.thread_))
-    {
-        std::cout << "Move Constructor is called" << std::endl;
-    }
- 
-    // Move Assignment Operator
-    LinuxThread & operator=(LinuxThread && obj)
-    {
-        std::cout << "Move Assignment is called" << std::endl;
-        if (thread_.joinable())
-            thread_.join();
-        thread_ = std::move(obj.thread_);
-        return *this;
-    }
-
-    // Destructor
-    ~LinuxThread() = default;
-
-    bool joinable()
-    {
-        return thread_.joinable();
+        samples++;
+        min_ns = std::min(min_ns, latency_ns);
+        max_ns = std::max(max_ns, latency_ns);
+        sum_ns += latency_ns;
     }
 
-    void join()
+    // upper edge of the bucket holding the fraction, in us
+    double PercentileUs(double fraction) const
     {
-        thread_.join();
+        uint64_t target = static_cast<uint64_t>(fraction * samples);
+        uint64_t seen{0};
+        for (int bucket = 0; bucket < kHistogramUs; bucket++) {
+            seen += buckets[bucket];
+            if (seen > target) return std::min(bucket + 1.0, max_ns / 1000.0);
+        }
+        return max_ns / 1000.0;
     }
+};
 
-private:
 
-    std::thread thread_;
-    std::string name_;
+struct Options
+{
+    long interval_us{1000};
+    long loops{5000};
+    int hogs{0};
+    int cpu{0};
+    int rt_priority{80};
 };
 
 
-void thread_1_handler(std::string name, int policy, int priority)
+int64_t to_ns(const timespec& ts)
 {
-    sched_param scheduler_params;
-    int current_policy; 
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
 
-    pthread_getschedparam(pthread_self(), &current_policy, &scheduler_params);
 
-    // configure priority/niceness
-    if (SCHED_OTHER == policy || SCHED_BATCH == policy || SCHED_IDLE == policy) {
+void advance(timespec& ts, long interval_ns)
+{
+    ts.tv_nsec += interval_ns;
+    while (ts.tv_nsec >= 1000000000) {
+        ts.tv_nsec -= 1000000000;
+        ts.tv_sec++;
+    }
+}
 
-        log("policy[CFS] : " + std::string(((SCHED_OTHER == policy) ? "SCHED_OTHER" :
-            (SCHED_BATCH == policy) ? "SCHED_BATCH" :
-                "SCHED_IDLE")));
 
-        /* set policy */
-        if (0 == pthread_setschedparam(pthread_self(), policy, &scheduler_params)) {
-            log("policy[REALTIME] : " + std::string(((policy == SCHED_FIFO)  ? "SCHED_FIFO" :
-                (policy == SCHED_RR)    ? "SCHED_RR" :
-                "SCHED_OTHER")));
-        } else {
-            std::cerr << "Failed to set Thread scheduling : " << std::strerror(errno) << std::endl;
-        }
+void measurement_handler(const Options& options, LatencyHistogram& histogram)
+{
+    long interval_ns = options.interval_us * 1000;
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
 
-        pid_t tid;
-        tid = syscall(SYS_gettid);
-        /* set niceness */
-        if (-1 == setpriority(PRIO_PROCESS, tid, priority)) {
-            log("setpriority() failure");
-        }
+    for (long loop = 0; loop < options.loops; loop++) {
 
-    } else {
+        advance(next, interval_ns);
+        // absolute deadline, no drift from the time spent recording
+        while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr)) {}
 
-        /* set priority */
-        scheduler_params.sched_priority = priority;
-        if (0 == pthread_setschedparam(pthread_self(), policy, &scheduler_params)) {
-            log("policy[REALTIME] : " + std::string(((policy == SCHED_FIFO)  ? "SCHED_FIFO" :
-                (policy == SCHED_RR)    ? "SCHED_RR" :
-                "SCHED_OTHER")));
-        } else {
-            std::cerr << "Failed to set Thread scheduling : " << std::strerror(errno) << std::endl;
-        }
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        histogram.Add(to_ns(now) - to_ns(next));
     }
+}
 
-    int run_count{0};
-    bool running{true};
 
-    while (running) {
+void hog_handler(std::atomic<bool>& running)
+{
+    volatile uint64_t spin{0};
+    while (running.load(std::memory_order_relaxed)) spin++;
+}
 
-        pthread_getschedparam(pthread_self(), &current_policy, &scheduler_params);
 
-        if (SCHED_OTHER == current_policy || SCHED_BATCH == current_policy || SCHED_IDLE == current_policy) {
+const char* policy_name(int policy)
+{
+    return (policy == SCHED_OTHER) ? "SCHED_OTHER" :
+        (policy == SCHED_BATCH) ? "SCHED_BATCH" :
+        (policy == SCHED_IDLE) ? "SCHED_IDLE" :
+        (policy == SCHED_FIFO) ? "SCHED_FIFO" :
+        (policy == SCHED_RR) ? "SCHED_RR" :
+        "???";
+}
 
-            pid_t tid;
-            tid = syscall(SYS_gettid);
-            int niceness = getpriority(PRIO_PROCESS, tid);
 
-            log("thread " + name + ", id = " + std::to_string(tid) + ", niceness = " + std::to_string(niceness)
-                + ", policy = " + std::string(((current_policy == SCHED_OTHER)  ? "SCHED_OTHER" :
-                    (current_policy == SCHED_BATCH)    ? "SCHED_BATCH" :
-                    (current_policy == SCHED_IDLE) ? "SCHED_IDLE" :
-                    "???")));
-        } else {
+bool realtime_permitted()
+{
+    rlimit rtprio;
+    return 0 == geteuid() || (0 == getrlimit(RLIMIT_RTPRIO, &rtprio) && rtprio.rlim_cur > 0);
+}
 
-            std::stringstream ss;
-            ss << std::this_thread::get_id();
-            log("thread " + name + ", id = " + ss.str() + ", priority = " + std::to_string(scheduler_params.sched_priority) 
-                + ", policy = " + std::string(((policy == SCHED_FIFO)  ? "SCHED_FIFO" :
-                    (policy == SCHED_RR)    ? "SCHED_RR" :
-                    (policy == SCHED_OTHER) ? "SCHED_OTHER" :
-                    "???")));
-        }
 
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        if (2 == run_count++) running = false;
+Options parse_options(int argc, char* argv[])
+{
+    Options options;
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "i:l:H:c:p:"))) {
+        switch (opt) {
+            case 'i': options.interval_us = std::atol(optarg); break;
+            case 'l': options.loops = std::atol(optarg); break;
+            case 'H': options.hogs = std::atoi(optarg); break;
+            case 'c': options.cpu = std::atoi(optarg); break;
+            case 'p': options.rt_priority = std::atoi(optarg); break;
+            default:
+                std::cerr << "usage : " << argv[0] << " [-i interval_us] [-l loops] [-H hogs] [-c cpu] [-p rt_priority]" << std::endl;
+                std::exit(1);
+        }
     }
+    return options;
 }
 
 
-int main() 
+int main(int argc, char* argv[])
 {
+    Options options = parse_options(argc, argv);
+
     cout<<"SCHED_OTHER max priority : "<<sched_get_priority_max(SCHED_OTHER)<<endl;
     cout<<"SCHED_BATCH max priority : "<<sched_get_priority_max(SCHED_BATCH)<<endl;
     cout<<"SCHED_IDLE max priority : "<<sched_get_priority_max(SCHED_IDLE)<<endl;
-    cout<<"SCHED_IDLE max priority : "<<sched_get_priority_max(SCHED_FIFO)<<endl;
+    cout<<"SCHED_FIFO max priority : "<<sched_get_priority_max(SCHED_FIFO)<<endl;
     cout<<"SCHED_RR max priority : "<<sched_get_priority_max(SCHED_RR)<<endl;
 
-    thread thread_1(thread_1_handler, "thread_1", 0, 0);
+    log("interval " + std::to_string(options.interval_us) + " us, loops " + std::to_string(options.loops)
+        + ", hogs " + std::to_string(options.hogs) + ", cpu " + std::to_string(options.cpu));
 
     /* For processes scheduled under one of the normal scheduling policies (SCHED_OTHER, SCHED_IDLE, SCHED_BATCH),
-       sched_priority is not used in scheduling decisions (it must be specified as 0). Instead use setpriority()
-       to configure niceness level.
-    */
+       sched_priority is not used in scheduling decisions (it must be specified as 0).
 
-    // SCHED_OTHER - the standard round-robin time-sharing policy;
-    LinuxThread thread_linux_other = LinuxThread(thread_1_handler, "thread_linux_other", SCHED_OTHER, 3);
-    // SCHED_BATCH - for "batch" style execution of processes
-    LinuxThread thread_linux_batch = LinuxThread(thread_1_handler, "thread_linux_batch", SCHED_BATCH, 4);
-    // SCHED_IDLE - for running very low priority background jobs.
-    LinuxThread thread_linux_idle = LinuxThread(thread_1_handler, "thread_linux_idle", SCHED_IDLE, 5);
-
-    /* The following "real-time" policies are also supported, for special time-critical applications that need precise 
+       The "real-time" policies SCHED_FIFO and SCHED_RR are for special time-critical applications that need precise
        control over the way in which runnable processes are selected for execution
     */
+    std::vector<int> policies = {SCHED_OTHER, SCHED_BATCH, SCHED_IDLE, SCHED_FIFO, SCHED_RR};
+
+    std::ostringstream report;
+    report << std::left << std::setw(12) << "policy" << std::right
+        << std::setw(10) << "min(us)" << std::setw(10) << "avg(us)" << std::setw(10) << "p99(us)"
+        << std::setw(10) << "p99.9(us)" << std::setw(10) << "max(us)" << std::setw(10) << "overflow" << "\n";
+
+    for (int policy : policies) {
+
+        bool realtime = (SCHED_FIFO == policy || SCHED_RR == policy);
+        if (realtime && !realtime_permitted()) {
+            log(std::string(policy_name(policy)) + " skipped, needs rtprio privileges");
+            continue;
+        }
+
+        // hogs compete for the measurement cpu under the default policy
+        std::atomic<bool> hogs_running{true};
+        std::vector<LinuxThread> hogs;
+        hogs.reserve(options.hogs);
+        for (int hog = 0; hog < options.hogs; hog++) {
+            hogs.emplace_back([&hogs_running]() { hog_handler(hogs_running); }, ThreadAttributes().Affinity(options.cpu));
+        }
+
+        LatencyHistogram histogram;
+        ThreadAttributes attributes = ThreadAttributes().Policy(policy).Affinity(options.cpu);
+        if (realtime) attributes.Priority(options.rt_priority);
+
+        LinuxThread measurement([&options, &histogram]() { measurement_handler(options, histogram); }, attributes);
+        bool started = measurement.Joinable();
+        measurement.Join();
+
+        hogs_running.store(false);
+        for (auto& hog : hogs) hog.Join();
+
+        // e.g. -c names a cpu outside the affinity mask, pthread_create() failed and was logged
+        if (!started) {
+            log(std::string(policy_name(policy)) + " skipped, measurement thread not created");
+            continue;
+        }
+
+        report << std::left << std::setw(12) << policy_name(policy) << std::right << std::fixed << std::setprecision(1)
+            << std::setw(10) << histogram.min_ns / 1000.0
+            << std::setw(10) << histogram.sum_ns / 1000.0 / std::max<uint64_t>(1, histogram.samples)
+            << std::setw(10) << histogram.PercentileUs(0.99)
+            << std::setw(10) << histogram.PercentileUs(0.999)
+            << std::setw(10) << histogram.max_ns / 1000.0
+            << std::setw(10) << histogram.overflows << "\n";
+    }
 
-    // SCHED_FIFO - a first-in, first-out policy
-    LinuxThread thread_linux_fifo = LinuxThread(thread_1_handler, "thread_linux_fifo", SCHED_FIFO, 1);
-    // SCHED_RR - a round-robin policy
-    LinuxThread thread_linux_rr = LinuxThread(thread_1_handler, "thread_linux_rr", SCHED_RR, 2);
-
-    if (thread_1.joinable()) thread_1.join();
-    if (thread_linux_other.joinable()) thread_linux_other.join();
-    if (thread_linux_batch.joinable()) thread_linux_batch.join();
-    if (thread_linux_idle.joinable()) thread_linux_idle.join();
-    if (thread_linux_fifo.joinable()) thread_linux_fifo.join();
-    if (thread_linux_rr.joinable()) thread_linux_rr.join();
+    log(report.str());
 
     return 0;
 }
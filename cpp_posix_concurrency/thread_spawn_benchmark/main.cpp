@@ -0,0 +1,163 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp ../util/RtAllocGuard.cpp -o thread_spawn_benchmark
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp ../util/RtAllocGuard.cpp -o thread_spawn_benchmark
+
+// thread spawn rate and heap traffic of LinuxThread construction and moves
+// - legacy : the previous LinuxThread start path (std::function, std::string name, shared_ptr state,
+//   heap start block), kept here as the before number
+// - linux_thread : current LinuxThread (InplaceFunction, ThreadName, pooled state)
+// - std_thread : std::thread as the reference
+// - every spawn builds a named thread with a small capture, moves it twice, joins and destroys it
+// - allocations are malloc / free calls made by the spawning thread (RtAllocGuard.cpp interposer),
+//   pthread_create's own bookkeeping included
+// $ ./thread_spawn_benchmark [spawns]
+
+#include "LinuxThread.h"
+#include "RealTimeMemory.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <pthread.h>
+#include <string>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+
+// replica of the LinuxThread start path before allocation free construction
+class LegacyThread
+{
+
+public:
+
+    LegacyThread(std::function<void(std::string)> func, std::string name) :
+        name_(name)
+    {
+        state_ = std::make_shared<State>();
+        std::unique_ptr<StartBlock> start(new StartBlock{[func, name]() { func(name); }, state_});
+        if (0 != pthread_create(&thread_, nullptr, Trampoline, start.get())) return;
+        start.release();
+        joinable_ = true;
+    }
+
+    // Delete the copy constructor
+    LegacyThread(const LegacyThread&) = delete;
+
+    // Delete the Assignment opeartor
+    LegacyThread& operator=(const LegacyThread&) = delete;
+
+    LegacyThread(LegacyThread && obj) :
+        thread_(obj.thread_),
+        state_(std::move(obj.state_)),
+        joinable_(obj.joinable_)
+    {
+        obj.joinable_ = false;
+    }
+
+    ~LegacyThread()
+    {
+        if (joinable_) pthread_join(thread_, nullptr);
+    }
+
+private:
+
+    struct State
+    {
+        std::atomic<pid_t> tid{0};
+    };
+
+    struct StartBlock
+    {
+        std::function<void()> func;
+        std::shared_ptr<State> state;
+    };
+
+    static void* Trampoline(void* arg)
+    {
+        std::unique_ptr<StartBlock> start(static_cast<StartBlock*>(arg));
+        start->state->tid.store(syscall(SYS_gettid), std::memory_order_release);
+        start->func();
+        return nullptr;
+    }
+
+    pthread_t thread_;
+    std::shared_ptr<State> state_;
+    bool joinable_{false};
+    std::string name_;
+};
+
+
+struct Result
+{
+    double spawns_per_sec;
+    double allocations_per_spawn;
+};
+
+
+// spawn(idx) builds, moves, joins and destroys one thread
+template <typename Spawn>
+Result run(int spawns, Spawn spawn)
+{
+    // warm up thread stacks and pools
+    for (int idx = 0; idx < 64; idx++) spawn(idx);
+
+    RealTimeMemory::MarkRealTimeThread(true);
+    uint64_t allocations = RealTimeMemory::RealTimeAllocations();
+    auto start = std::chrono::steady_clock::now();
+
+    for (int idx = 0; idx < spawns; idx++) spawn(idx);
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    allocations = RealTimeMemory::RealTimeAllocations() - allocations;
+    RealTimeMemory::MarkRealTimeThread(false);
+
+    return {spawns / elapsed, static_cast<double>(allocations) / spawns};
+}
+
+
+int main(int argc, char* argv[])
+{
+    int spawns = argc > 1 ? std::atoi(argv[1]) : 20000;
+    if (spawns <= 0) {
+        std::fprintf(stderr, "usage : %s [spawns]\n", argv[0]);
+        return 1;
+    }
+
+    RealTimeMemory::SetAllocationMode(RealTimeMemory::AllocationMode::COUNT);
+    LinuxThread::Reserve(4);
+
+    std::atomic<uint64_t> sink{0};
+    const std::string name = "spawn_worker";
+
+    Result legacy = run(spawns, [&](int idx) {
+        LegacyThread thread([&sink, idx](std::string) { sink.fetch_add(idx, std::memory_order_relaxed); }, name);
+        LegacyThread moved(std::move(thread));
+        LegacyThread last(std::move(moved));
+    });
+
+    Result linux_thread = run(spawns, [&](int idx) {
+        LinuxThread thread([&sink, idx](std::string) { sink.fetch_add(idx, std::memory_order_relaxed); }, "spawn_worker");
+        LinuxThread moved(std::move(thread));
+        LinuxThread last(std::move(moved));
+    });
+
+    Result std_thread = run(spawns, [&](int idx) {
+        std::thread thread([&sink, idx]() { sink.fetch_add(idx, std::memory_order_relaxed); });
+        std::thread moved(std::move(thread));
+        std::thread last(std::move(moved));
+        last.join();
+    });
+
+    std::printf("%-14s %14s %18s\n", "variant", "spawns/sec", "allocations/spawn");
+    std::printf("%-14s %14.0f %18.2f\n", "legacy", legacy.spawns_per_sec, legacy.allocations_per_spawn);
+    std::printf("%-14s %14.0f %18.2f\n", "linux_thread", linux_thread.spawns_per_sec, linux_thread.allocations_per_spawn);
+    std::printf("%-14s %14.0f %18.2f\n", "std_thread", std_thread.spawns_per_sec, std_thread.allocations_per_spawn);
+    std::printf("speedup over legacy : %.2fx\n", linux_thread.spawns_per_sec / legacy.spawns_per_sec);
+
+    return 0;
+}
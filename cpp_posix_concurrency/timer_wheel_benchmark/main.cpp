@@ -0,0 +1,240 @@
+// compiler options
+// $ g++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/TimerWheel.cpp ../util/ThreadPool.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o timer_wheel_benchmark
+// $ clang++ -O2 -std=c++17 -I../util -pthread main.cpp ../util/TimerWheel.cpp ../util/ThreadPool.cpp ../util/CpuTopology.cpp ../util/LinuxThread.cpp ../util/SyncLog.cpp ../util/ThreadAttributes.cpp ../util/RealTimeMemory.cpp -o timer_wheel_benchmark
+
+// mass timeouts : TimerWheel vs a std::priority_queue vs one sleeping thread per timer
+// - insert : schedule n timers with random delays of up to 10 minutes at 1 ms ticks
+// - cancel : cancel a random half of them (the priority queue can only mark them, the heap keeps them)
+// - expire : run the clock forward until every remaining timer has fired (no real waiting)
+// - thread per timer : a sleeping std::thread per timer cannot reach a million timers, it runs a few
+//   thousand short timers instead, expire there is the wall time from the last deadline to the last join
+// - finally a timerfd driven wheel fires timers for real onto a ThreadPool and reports the lateness,
+//   the run fails when any timer fired before its delay
+// $ ./timer_wheel_benchmark [timers] [threads for thread per timer]
+
+#include "ThreadPool.h"
+#include "TimerWheel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr uint64_t kMaxDelayTicks = 10 * 60 * 1000;
+
+
+struct Rates
+{
+    double inserts_per_sec;
+    double cancels_per_sec;
+    double expires_per_sec;
+    uint64_t fired;
+};
+
+
+double seconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+
+Rates run_wheel(const std::vector<uint64_t>& delays, const std::vector<std::size_t>& cancels)
+{
+    InlineExecutor inline_executor;
+    TimerWheel wheel(inline_executor, std::chrono::milliseconds(1), TimerWheel::Drive::MANUAL);
+    uint64_t fired{0};
+    Rates rates{};
+
+    std::vector<TimerWheel::TimerId> ids(delays.size());
+    auto start = Clock::now();
+    for (std::size_t idx = 0; idx < delays.size(); idx++) {
+        ids[idx] = wheel.Schedule(std::chrono::milliseconds(delays[idx]), [&fired]() { fired++; });
+    }
+    rates.inserts_per_sec = delays.size() / seconds_since(start);
+
+    start = Clock::now();
+    for (std::size_t idx : cancels) wheel.Cancel(ids[idx]);
+    rates.cancels_per_sec = cancels.size() / seconds_since(start);
+
+    std::size_t remaining = wheel.Pending();
+    start = Clock::now();
+    while (wheel.Pending()) wheel.Expire(1024);
+    rates.expires_per_sec = remaining / seconds_since(start);
+    rates.fired = fired;
+    return rates;
+}
+
+
+// min heap on deadline, cancellation marks the entry and the pop skips it
+Rates run_heap(const std::vector<uint64_t>& delays, const std::vector<std::size_t>& cancels)
+{
+    struct Entry
+    {
+        uint64_t deadline;
+        std::size_t id;
+        std::function<void()> callback;
+        bool operator>(const Entry& other) const { return deadline > other.deadline; }
+    };
+
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+    std::vector<bool> cancelled(delays.size(), false);
+    uint64_t fired{0};
+    Rates rates{};
+
+    auto start = Clock::now();
+    for (std::size_t idx = 0; idx < delays.size(); idx++) {
+        heap.push({delays[idx], idx, [&fired]() { fired++; }});
+    }
+    rates.inserts_per_sec = delays.size() / seconds_since(start);
+
+    start = Clock::now();
+    for (std::size_t idx : cancels) cancelled[idx] = true;
+    rates.cancels_per_sec = cancels.size() / seconds_since(start);
+
+    std::size_t remaining = delays.size() - cancels.size();
+    start = Clock::now();
+    for (uint64_t now = 0; !heap.empty(); now += 1024) {
+        while (!heap.empty() && heap.top().deadline <= now) {
+            // top() is const, the callback is copied out
+            Entry entry = heap.top();
+            heap.pop();
+            if (!cancelled[entry.id]) entry.callback();
+        }
+    }
+    rates.expires_per_sec = remaining / seconds_since(start);
+    rates.fired = fired;
+    return rates;
+}
+
+
+// one thread per timer sleeping on its own condition variable until the deadline or cancellation
+Rates run_threads(std::size_t count)
+{
+    struct Timer
+    {
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool cancelled{false};
+    };
+
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<int> delay_ms(100, 300);
+    std::vector<std::unique_ptr<Timer>> timers;
+    std::vector<std::thread> threads;
+    std::atomic<uint64_t> fired{0};
+    Rates rates{};
+
+    auto start = Clock::now();
+    Clock::time_point last_deadline = start;
+    for (std::size_t idx = 0; idx < count; idx++) {
+        timers.emplace_back(new Timer);
+        Timer* timer = timers.back().get();
+        Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(delay_ms(rng));
+        last_deadline = std::max(last_deadline, deadline);
+        threads.emplace_back([timer, deadline, &fired]() {
+            std::unique_lock<std::mutex> lck (timer->mtx);
+            if (!timer->cv.wait_until(lck, deadline, [timer]() { return timer->cancelled; })) fired++;
+        });
+    }
+    rates.inserts_per_sec = count / seconds_since(start);
+
+    start = Clock::now();
+    for (std::size_t idx = 0; idx < count; idx += 2) {
+        {
+            std::lock_guard<std::mutex> lck (timers[idx]->mtx);
+            timers[idx]->cancelled = true;
+        }
+        timers[idx]->cv.notify_one();
+    }
+    rates.cancels_per_sec = (count + 1) / 2 / seconds_since(start);
+
+    std::this_thread::sleep_until(last_deadline);
+    start = Clock::now();
+    for (auto& thread : threads) thread.join();
+    rates.expires_per_sec = count / 2 / seconds_since(start);
+    rates.fired = fired;
+    return rates;
+}
+
+
+// timerfd driven wheel firing onto a pool, lateness against the requested deadline, false when a timer fired early
+bool run_live(std::size_t count)
+{
+    ThreadPool pool;
+    TimerWheel wheel(pool, std::chrono::milliseconds(1));
+
+    std::mt19937_64 rng(11);
+    std::uniform_int_distribution<int> delay_us(1000, 500000);
+    std::vector<int64_t> lateness_ns(count);
+    std::atomic<std::size_t> fired{0};
+
+    for (std::size_t idx = 0; idx < count; idx++) {
+        auto delay = std::chrono::microseconds(delay_us(rng));
+        Clock::time_point deadline = Clock::now() + delay;
+        wheel.Schedule(delay, [&lateness_ns, &fired, idx, deadline]() {
+            lateness_ns[idx] = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - deadline).count();
+            fired.fetch_add(1, std::memory_order_release);
+        });
+    }
+    while (fired.load(std::memory_order_acquire) < count) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::sort(lateness_ns.begin(), lateness_ns.end());
+    auto percentile = [&lateness_ns](double pct) {
+        return static_cast<long>(lateness_ns[static_cast<std::size_t>(pct * (lateness_ns.size() - 1))] / 1000);
+    };
+    std::printf("timerfd wheel, %zu timers over 0.5 s on %u pool workers : lateness min %ld us, p50 %ld us, p99 %ld us, max %ld us\n",
+        count, pool.WorkerCount(), percentile(0.0), percentile(0.5), percentile(0.99), percentile(1.0));
+
+    // a timer must never fire before its delay
+    std::size_t early = std::lower_bound(lateness_ns.begin(), lateness_ns.end(), 0) - lateness_ns.begin();
+    if (early) std::printf("%zu TIMERS FIRED EARLY\n", early);
+    return 0 == early;
+}
+
+
+void print(const char* name, std::size_t timers, const Rates& rates)
+{
+    std::printf("%-18s %9zu %14.0f %14.0f %14.0f %10llu\n", name, timers, rates.inserts_per_sec, rates.cancels_per_sec,
+        rates.expires_per_sec, static_cast<unsigned long long>(rates.fired));
+}
+
+
+int main(int argc, char* argv[])
+{
+    std::size_t timers = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::size_t thread_timers = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 2000;
+    if (0 == timers || 0 == thread_timers) {
+        std::fprintf(stderr, "usage : %s [timers] [threads for thread per timer]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937_64 rng(3);
+    std::uniform_int_distribution<uint64_t> delay(1, kMaxDelayTicks);
+    std::vector<uint64_t> delays(timers);
+    for (auto& ticks : delays) ticks = delay(rng);
+
+    std::vector<std::size_t> cancels(timers);
+    for (std::size_t idx = 0; idx < timers; idx++) cancels[idx] = idx;
+    std::shuffle(cancels.begin(), cancels.end(), rng);
+    cancels.resize(timers / 2);
+
+    std::printf("%-18s %9s %14s %14s %14s %10s\n", "", "timers", "inserts/sec", "cancels/sec", "expires/sec", "fired");
+    print("timer_wheel", timers, run_wheel(delays, cancels));
+    print("priority_queue", timers, run_heap(delays, cancels));
+    print("thread_per_timer", thread_timers, run_threads(thread_timers));
+
+    return run_live(std::min<std::size_t>(timers, 100000)) ? 0 : 1;
+}
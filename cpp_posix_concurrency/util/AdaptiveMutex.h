@@ -0,0 +1,98 @@
+#pragma once
+
+#include "CacheLine.h"
+#include "Futex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+// spin then park mutex for short critical sections
+// - uncontended lock / unlock are a single atomic each, no syscall
+// - a contended lock spins with CpuRelax() and exponential backoff, then parks on a futex
+// - the spin budget follows the spins that successful acquisitions needed, so it grows while holders release
+//   quickly and shrinks when spinning ends in a park anyway (long holds, or the holder is preempted)
+// - meets the std Lockable requirements, use it with std::lock_guard / std::unique_lock
+
+class AdaptiveMutex
+{
+
+public:
+
+    AdaptiveMutex() = default;
+
+    // Delete the copy constructor
+    AdaptiveMutex(const AdaptiveMutex&) = delete;
+
+    // Delete the Assignment opeartor
+    AdaptiveMutex& operator=(const AdaptiveMutex&) = delete;
+
+    void lock()
+    {
+        uint32_t state = kUnlocked;
+        if (state_.compare_exchange_strong(state, kLocked, std::memory_order_acquire, std::memory_order_relaxed)) return;
+
+        // spin, reading only, until the holder lets go or the budget runs out
+        uint32_t limit = spin_limit_.load(std::memory_order_relaxed);
+        uint32_t spins{0};
+        uint32_t backoff{1};
+        while (spins < limit) {
+            for (uint32_t i = 0; i < backoff; i++) CpuRelax();
+            spins += backoff;
+            backoff = std::min(backoff * 2, kMaxBackoff);
+
+            state = state_.load(std::memory_order_relaxed);
+            if (kUnlocked == state &&
+                state_.compare_exchange_weak(state, kLocked, std::memory_order_acquire, std::memory_order_relaxed)) {
+                // move the budget an eighth of the way towards twice what this acquisition needed
+                Adapt(limit, std::clamp(2 * spins, kMinSpins, kMaxSpins));
+                return;
+            }
+        }
+
+        // park, the lock word stays at kContended while anyone may be sleeping
+        if (kContended != state) state = state_.exchange(kContended, std::memory_order_acquire);
+        while (kUnlocked != state) {
+            FutexWait(&state_, kContended);
+            state = state_.exchange(kContended, std::memory_order_acquire);
+        }
+        Adapt(limit, kMinSpins);
+    }
+
+    bool try_lock()
+    {
+        uint32_t state = kUnlocked;
+        return state_.compare_exchange_strong(state, kLocked, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock()
+    {
+        if (kContended == state_.exchange(kUnlocked, std::memory_order_release)) FutexWake(&state_, 1);
+    }
+
+    // current spin budget in CpuRelax() iterations
+    uint32_t SpinLimit() const
+    {
+        return spin_limit_.load(std::memory_order_relaxed);
+    }
+
+    static constexpr uint32_t kMinSpins = 16;
+    static constexpr uint32_t kMaxSpins = 4096;
+
+private:
+
+    void Adapt(uint32_t limit, uint32_t target)
+    {
+        int32_t step = (static_cast<int32_t>(target) - static_cast<int32_t>(limit)) / 8;
+        spin_limit_.store(limit + step, std::memory_order_relaxed);
+    }
+
+    static constexpr uint32_t kUnlocked = 0;
+    static constexpr uint32_t kLocked = 1;
+    static constexpr uint32_t kContended = 2;
+    static constexpr uint32_t kMaxBackoff = 64;
+
+    // the lock word gets a line of its own, the spin budget is only a hint and shares it
+    alignas(kCacheLineSize) std::atomic<uint32_t> state_{kUnlocked};
+    std::atomic<uint32_t> spin_limit_{kMinSpins * 8};
+};
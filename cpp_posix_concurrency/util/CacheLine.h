@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstddef>
+
+// destructive interference size assumed for x86_64 and the cortex-a cores on the pi boards
+constexpr std::size_t kCacheLineSize = 64;
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "CacheLine.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Chase-Lev work stealing deque (Le, Pop, Cohen, Zappa Nardelli - "Correct and Efficient Work-Stealing
+// for Weak Memory Models")
+// - the owner pushes and pops at the bottom, thieves steal from the top
+// - T must be trivially copyable, typically a task pointer
+// - the buffer grows on push, retired buffers are kept until destruction since a thief may still read them
+
+template <typename T>
+class ChaseLevDeque
+{
+
+public:
+
+    explicit ChaseLevDeque(std::size_t capacity = 1024)
+    {
+        std::size_t pow2 = 1;
+        while (pow2 < capacity) pow2 <<= 1;
+        buffers_.emplace_back(new Buffer(pow2));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    // owner only
+    void Push(T item)
+    {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(buffer->mask)) buffer = Grow(buffer, top, bottom);
+        buffer->Put(bottom, item);
+        // release store rather than fence + relaxed store, same ordering and visible to tsan
+        bottom_.store(bottom + 1, std::memory_order_release);
+    }
+
+    // owner only
+    bool Pop(T& item)
+    {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            // empty
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = buffer->Get(bottom);
+        if (top == bottom) {
+            // last item, race the thieves for it
+            bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // any thread, fails when empty or when losing a race with another thief / the owner
+    bool Steal(T& item)
+    {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+
+        if (top >= bottom) return false;
+
+        Buffer* buffer = buffer_.load(std::memory_order_acquire);
+        T stolen = buffer->Get(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        item = stolen;
+        return true;
+    }
+
+    // approximate, any thread
+    bool Empty() const
+    {
+        return top_.load(std::memory_order_acquire) >= bottom_.load(std::memory_order_acquire);
+    }
+
+private:
+
+    struct Buffer
+    {
+        explicit Buffer(std::size_t capacity) : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+
+        T Get(int64_t idx) const { return slots[idx & mask].load(std::memory_order_relaxed); }
+        void Put(int64_t idx, T item) { slots[idx & mask].store(item, std::memory_order_relaxed); }
+
+        const std::size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Buffer* Grow(Buffer* buffer, int64_t top, int64_t bottom)
+    {
+        buffers_.emplace_back(new Buffer(2 * (buffer->mask + 1)));
+        Buffer* grown = buffers_.back().get();
+        for (int64_t idx = top; idx < bottom; idx++) grown->Put(idx, buffer->Get(idx));
+        buffer_.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+    alignas(kCacheLineSize) std::atomic<int64_t> top_{0};
+    alignas(kCacheLineSize) std::atomic<int64_t> bottom_{0};
+    alignas(kCacheLineSize) std::atomic<Buffer*> buffer_{nullptr};
+    // owner only, current buffer is buffers_.back()
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+};
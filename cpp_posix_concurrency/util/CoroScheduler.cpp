@@ -0,0 +1,98 @@
+// C++20 : build with -std=c++20
+
+#include "CoroScheduler.h"
+
+
+CoroScheduler::CoroScheduler(unsigned int num_workers) :
+    pool_(num_workers),
+    timer_thread_([this]() { TimerLoop(); })
+{
+}
+
+
+CoroScheduler::~CoroScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lck (timer_mtx_);
+        stopping_ = true;
+    }
+    timer_cv_.notify_one();
+    timer_thread_.Join();
+}
+
+
+Future<bool> CoroScheduler::Spawn(Task<void> task)
+{
+    Promise<bool> promise;
+    Future<bool> future = promise.GetFuture();
+    Schedule(DriveVoid(std::move(task), promise).handle);
+    return future;
+}
+
+
+void CoroScheduler::Schedule(std::coroutine_handle<> handle)
+{
+    pool_.Execute([handle]() { handle.resume(); });
+}
+
+
+Executor& CoroScheduler::GetExecutor()
+{
+    return pool_;
+}
+
+
+CoroScheduler::Detached CoroScheduler::DriveVoid(Task<void> task, Promise<bool> promise)
+{
+    try {
+        co_await task;
+        promise.SetValue(true);
+    } catch (...) {
+        promise.SetException(std::current_exception());
+    }
+}
+
+
+void CoroScheduler::AddTimer(std::chrono::steady_clock::time_point deadline, std::coroutine_handle<> handle)
+{
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lck (timer_mtx_);
+        earliest = timers_.empty() || deadline < timers_.top().deadline;
+        timers_.push({deadline, handle});
+    }
+    if (earliest) timer_cv_.notify_one();
+}
+
+
+void CoroScheduler::TimerLoop()
+{
+    std::vector<std::coroutine_handle<>> expired;
+    std::unique_lock<std::mutex> lck (timer_mtx_);
+
+    while (!stopping_) {
+
+        if (timers_.empty()) {
+            timer_cv_.wait(lck);
+            continue;
+        }
+
+        // copy, wait_until() keeps a reference and a push can reallocate the heap
+        auto now = std::chrono::steady_clock::now();
+        auto earliest = timers_.top().deadline;
+        if (earliest > now) {
+            timer_cv_.wait_until(lck, earliest);
+            continue;
+        }
+
+        // hand every expired timer to the workers outside the lock
+        while (!timers_.empty() && timers_.top().deadline <= now) {
+            expired.push_back(timers_.top().handle);
+            timers_.pop();
+        }
+        lck.unlock();
+        for (auto handle : expired) Schedule(handle);
+        expired.clear();
+        lck.lock();
+    }
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+// C++20 : build users of this header with -std=c++20
+
+#include "Future.h"
+#include "LinuxThread.h"
+#include "Task.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+// runs coroutine Tasks on a fixed set of ThreadPool (LinuxThread) workers
+// - Sleep() parks the coroutine on a single timer thread instead of blocking a worker
+// - Await() parks the coroutine on a Future until its value is ready
+// - wait for the futures returned by Spawn() before destroying the scheduler, suspended coroutines are not resumed
+//   once it is gone
+
+class CoroScheduler
+{
+
+public:
+
+    explicit CoroScheduler(unsigned int num_workers = CpuTopology::EffectiveConcurrency());
+
+    // Delete the copy constructor
+    CoroScheduler(const CoroScheduler&) = delete;
+
+    // Delete the Assignment opeartor
+    CoroScheduler& operator=(const CoroScheduler&) = delete;
+
+    ~CoroScheduler();
+
+    // start a top level task on a worker, the future carries its result
+    template <typename T>
+    Future<T> Spawn(Task<T> task);
+
+    // void tasks complete with true
+    Future<bool> Spawn(Task<void> task);
+
+    // awaitable, resumes on a worker once duration has passed
+    auto Sleep(std::chrono::steady_clock::duration duration);
+
+    // awaitable, resumes on a worker once future is ready and yields its value
+    template <typename T>
+    auto Await(Future<T> future);
+
+    // resume handle on a worker
+    void Schedule(std::coroutine_handle<> handle);
+
+    Executor& GetExecutor();
+
+private:
+
+    // fire and forget coroutine driving a top level task, its frame frees itself on completion
+    struct Detached
+    {
+        struct promise_type
+        {
+            Detached get_return_object() { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    template <typename T>
+    static Detached Drive(Task<T> task, Promise<T> promise);
+
+    static Detached DriveVoid(Task<void> task, Promise<bool> promise);
+
+    struct Timer
+    {
+        std::chrono::steady_clock::time_point deadline;
+        std::coroutine_handle<> handle;
+
+        bool operator>(const Timer& other) const { return deadline > other.deadline; }
+    };
+
+    void AddTimer(std::chrono::steady_clock::time_point deadline, std::coroutine_handle<> handle);
+    void TimerLoop();
+
+    ThreadPool pool_;
+
+    std::mutex timer_mtx_;
+    std::condition_variable timer_cv_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    bool stopping_{false};
+    LinuxThread timer_thread_;
+};
+
+
+template <typename T>
+CoroScheduler::Detached CoroScheduler::Drive(Task<T> task, Promise<T> promise)
+{
+    try {
+        promise.SetValue(co_await task);
+    } catch (...) {
+        promise.SetException(std::current_exception());
+    }
+}
+
+
+template <typename T>
+Future<T> CoroScheduler::Spawn(Task<T> task)
+{
+    Promise<T> promise;
+    Future<T> future = promise.GetFuture();
+    Schedule(Drive(std::move(task), promise).handle);
+    return future;
+}
+
+
+inline auto CoroScheduler::Sleep(std::chrono::steady_clock::duration duration)
+{
+    struct SleepAwaiter
+    {
+        CoroScheduler& scheduler;
+        std::chrono::steady_clock::time_point deadline;
+
+        bool await_ready() const { return deadline <= std::chrono::steady_clock::now(); }
+        void await_suspend(std::coroutine_handle<> handle) { scheduler.AddTimer(deadline, handle); }
+        void await_resume() {}
+    };
+
+    return SleepAwaiter{*this, std::chrono::steady_clock::now() + duration};
+}
+
+
+template <typename T>
+auto CoroScheduler::Await(Future<T> future)
+{
+    struct FutureAwaiter
+    {
+        Future<T> future;
+        Executor& executor;
+
+        bool await_ready() const { return future.Ready(); }
+        void await_suspend(std::coroutine_handle<> handle) { future.OnReady(executor, [handle]() { handle.resume(); }); }
+        T await_resume() { return future.Get(); }
+    };
+
+    return FutureAwaiter{std::move(future), pool_};
+}
@@ -0,0 +1,333 @@
+#include "CpuTopology.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+namespace {
+
+std::string read_line(const std::string& path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+int read_int(const std::string& path, int fallback)
+{
+    std::string line = read_line(path);
+    return line.empty() ? fallback : std::stoi(line);
+}
+
+cpu_set_t make_cpu_set(const std::vector<int>& cpus)
+{
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (int cpu : cpus) CPU_SET(cpu, &cpuset);
+    return cpuset;
+}
+
+// cgroup2 mount point and the process cgroup below it ("0::/path" in /proc/self/cgroup), empty mount when absent
+std::pair<std::string, std::string> cgroup_v2_dir()
+{
+    std::string mount;
+    std::ifstream mounts("/proc/self/mounts");
+    std::string device, path, fstype, rest;
+    while (mounts >> device >> path >> fstype && std::getline(mounts, rest)) {
+        if ("cgroup2" == fstype) {
+            mount = path;
+            break;
+        }
+    }
+
+    std::string cgroup;
+    std::ifstream cgroups("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(cgroups, line)) {
+        if (0 == line.compare(0, 3, "0::")) cgroup = line.substr(3);
+    }
+    if ("/" == cgroup) cgroup.clear();
+
+    return {mount, cgroup};
+}
+
+}
+
+
+CpuTopology CpuTopology::Load(const std::string& sysfs_root)
+{
+    CpuTopology topology;
+
+    cpu_set_t allowed = EffectiveCpus();
+
+    std::vector<int> online = ParseCpuList(read_line(sysfs_root + "/online"));
+    for (int cpu : online) {
+
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+
+        std::string cpu_dir = sysfs_root + "/cpu" + std::to_string(cpu);
+        CpuInfo info;
+        info.cpu = cpu;
+        info.package_id = read_int(cpu_dir + "/topology/physical_package_id", 0);
+        info.core_id = read_int(cpu_dir + "/topology/core_id", cpu);
+        info.smt_siblings = ParseCpuList(read_line(cpu_dir + "/topology/thread_siblings_list"));
+        if (info.smt_siblings.empty()) info.smt_siblings.push_back(cpu);
+
+        // no cache info (some arm kernels) : every cpu is its own L2 domain, one LLC per package
+        info.l2_domain = cpu;
+        info.llc_domain = -1 - info.package_id;
+        int llc_level = 0;
+        for (int index = 0; ; index++) {
+            std::string cache_dir = cpu_dir + "/cache/index" + std::to_string(index);
+            int level = read_int(cache_dir + "/level", -1);
+            if (level < 0) break;
+            if ("Instruction" == read_line(cache_dir + "/type")) continue;
+
+            std::vector<int> shared = ParseCpuList(read_line(cache_dir + "/shared_cpu_list"));
+            int domain = shared.empty() ? cpu : shared.front();
+            if (2 == level) info.l2_domain = domain;
+            if (level >= llc_level) {
+                llc_level = level;
+                info.llc_domain = domain;
+            }
+        }
+
+        topology.cpus_.push_back(info);
+    }
+
+    // group hardware threads into physical cores
+    std::map<std::pair<int, int>, std::size_t> core_index;
+    for (const CpuInfo& info : topology.cpus_) {
+        auto key = std::make_pair(info.package_id, info.core_id);
+        auto found = core_index.find(key);
+        if (found == core_index.end()) {
+            core_index[key] = topology.cores_.size();
+            topology.cores_.push_back({info.package_id, info.core_id, info.l2_domain, info.llc_domain, {info.cpu}});
+        } else {
+            topology.cores_[found->second].cpus.push_back(info.cpu);
+        }
+    }
+
+    return topology;
+}
+
+
+cpu_set_t CpuTopology::EffectiveCpus()
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (0 != sched_getaffinity(0, sizeof(allowed), &allowed)) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, &allowed);
+    }
+
+    // the nearest cgroup with the cpuset controller enabled has the file
+    auto [mount, cgroup] = cgroup_v2_dir();
+    if (mount.empty()) return allowed;
+
+    for (std::string dir = cgroup; ; dir = dir.substr(0, dir.rfind('/'))) {
+        std::string cpu_list = read_line(mount + dir + "/cpuset.cpus.effective");
+        if (!cpu_list.empty()) {
+            cpu_set_t cpuset = make_cpu_set(ParseCpuList(cpu_list));
+            cpu_set_t effective;
+            CPU_AND(&effective, &allowed, &cpuset);
+            // a stale mask (cpuset changed under us) should not leave nothing to run on
+            return CPU_COUNT(&effective) ? effective : allowed;
+        }
+        if (dir.empty()) break;
+    }
+
+    return allowed;
+}
+
+
+double CpuTopology::CpuQuota()
+{
+    auto [mount, cgroup] = cgroup_v2_dir();
+    if (mount.empty()) return 0;
+
+    // "max 100000" or "<quota> <period>", a child can not use more than any ancestor
+    double quota{0};
+    for (std::string dir = cgroup; ; dir = dir.substr(0, dir.rfind('/'))) {
+        std::istringstream cpu_max(read_line(mount + dir + "/cpu.max"));
+        std::string max;
+        double period{0};
+        if (cpu_max >> max >> period && "max" != max && period > 0) {
+            double cpus = std::stod(max) / period;
+            if (0 == quota || cpus < quota) quota = cpus;
+        }
+        if (dir.empty()) break;
+    }
+
+    return quota;
+}
+
+
+unsigned int CpuTopology::EffectiveConcurrency()
+{
+    cpu_set_t cpus = EffectiveCpus();
+    unsigned int concurrency = CPU_COUNT(&cpus);
+
+    double quota = CpuQuota();
+    if (quota > 0) concurrency = std::min(concurrency, static_cast<unsigned int>(std::ceil(quota)));
+
+    return std::max(1u, concurrency);
+}
+
+
+unsigned int CpuTopology::EffectiveCpu(unsigned int idx)
+{
+    cpu_set_t cpus = EffectiveCpus();
+    unsigned int count = CPU_COUNT(&cpus);
+    if (0 == count) return idx;
+
+    unsigned int target = idx % count;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &cpus) && 0 == target--) return cpu;
+    }
+    return idx;
+}
+
+
+const std::vector<CpuInfo>& CpuTopology::Cpus() const
+{
+    return cpus_;
+}
+
+
+unsigned int CpuTopology::PhysicalCores() const
+{
+    return cores_.size();
+}
+
+
+unsigned int CpuTopology::LlcDomains() const
+{
+    std::vector<int> domains;
+    for (const Core& core : cores_) domains.push_back(core.llc_domain);
+    std::sort(domains.begin(), domains.end());
+    return std::unique(domains.begin(), domains.end()) - domains.begin();
+}
+
+
+std::vector<cpu_set_t> CpuTopology::Place(Placement placement, unsigned int num_threads) const
+{
+    if (cores_.empty()) {
+        // topology unreadable, leave placement to the scheduler
+        cpu_set_t any;
+        CPU_ZERO(&any);
+        if (0 != sched_getaffinity(0, sizeof(any), &any)) CPU_SET(0, &any);
+        return std::vector<cpu_set_t>(num_threads, any);
+    }
+
+    switch (placement) {
+        case Placement::SPREAD_CORES:
+            return SpreadCores(num_threads);
+        case Placement::PACK_LLC:
+            return PackLlc(num_threads);
+        case Placement::AVOID_SMT_SIBLINGS:
+        default:
+            return AvoidSmtSiblings(num_threads);
+    }
+}
+
+
+std::vector<cpu_set_t> CpuTopology::SpreadCores(unsigned int num_threads) const
+{
+    // greedy : next core is the one whose LLC, then L2, domain holds the fewest threads so far
+    std::map<int, int> llc_load;
+    std::map<int, int> l2_load;
+    std::vector<int> core_load(cores_.size(), 0);
+    std::vector<cpu_set_t> placement;
+
+    for (unsigned int thread_idx = 0; thread_idx < num_threads; thread_idx++) {
+        std::size_t best = 0;
+        for (std::size_t core_idx = 1; core_idx < cores_.size(); core_idx++) {
+            const Core& core = cores_[core_idx];
+            const Core& best_core = cores_[best];
+            auto load = std::make_tuple(core_load[core_idx], llc_load[core.llc_domain], l2_load[core.l2_domain]);
+            auto best_load = std::make_tuple(core_load[best], llc_load[best_core.llc_domain], l2_load[best_core.l2_domain]);
+            if (load < best_load) best = core_idx;
+        }
+
+        const Core& core = cores_[best];
+        // past one thread per core, fall back onto the SMT siblings
+        int cpu = core.cpus[core_load[best] % core.cpus.size()];
+        placement.push_back(make_cpu_set({cpu}));
+
+        core_load[best]++;
+        llc_load[core.llc_domain]++;
+        l2_load[core.l2_domain]++;
+    }
+    return placement;
+}
+
+
+std::vector<cpu_set_t> CpuTopology::PackLlc(unsigned int num_threads) const
+{
+    std::map<int, int> llc_cpus;
+    for (const Core& core : cores_) llc_cpus[core.llc_domain] += core.cpus.size();
+    int llc = std::max_element(llc_cpus.begin(), llc_cpus.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.second < rhs.second;
+    })->first;
+
+    // first hardware thread of every core in the domain, then the siblings
+    std::vector<int> order;
+    for (std::size_t smt_idx = 0; order.size() < static_cast<std::size_t>(llc_cpus[llc]); smt_idx++) {
+        for (const Core& core : cores_) {
+            if (core.llc_domain == llc && smt_idx < core.cpus.size()) order.push_back(core.cpus[smt_idx]);
+        }
+    }
+
+    std::vector<cpu_set_t> placement;
+    for (unsigned int thread_idx = 0; thread_idx < num_threads; thread_idx++) {
+        placement.push_back(make_cpu_set({order[thread_idx % order.size()]}));
+    }
+    return placement;
+}
+
+
+std::vector<cpu_set_t> CpuTopology::AvoidSmtSiblings(unsigned int num_threads) const
+{
+    std::vector<cpu_set_t> placement;
+    for (unsigned int thread_idx = 0; thread_idx < num_threads; thread_idx++) {
+        placement.push_back(make_cpu_set(cores_[thread_idx % cores_.size()].cpus));
+    }
+    return placement;
+}
+
+
+std::vector<int> CpuTopology::ParseCpuList(const std::string& cpu_list)
+{
+    std::vector<int> cpus;
+    std::stringstream ss(cpu_list);
+    std::string range;
+
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        std::size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = (std::string::npos == dash) ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+
+std::string CpuTopology::FormatCpuList(const cpu_set_t& cpus)
+{
+    std::string cpu_list;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &cpus)) continue;
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &cpus)) last++;
+        if (!cpu_list.empty()) cpu_list += ",";
+        cpu_list += std::to_string(cpu);
+        if (last > cpu) cpu_list += "-" + std::to_string(last);
+        cpu = last;
+    }
+    return cpu_list;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <sched.h>
+#include <string>
+#include <vector>
+
+// cpu / cache topology of the cpus this process may run on
+// - built from /sys/devices/system/cpu/cpu*/topology and cpu*/cache/index*
+// - cache domains are identified by the lowest cpu sharing the cache
+
+struct CpuInfo
+{
+    int cpu;
+    int package_id;
+    int core_id;
+    // lowest cpu sharing the L2 / last level cache with this cpu
+    int l2_domain;
+    int llc_domain;
+    // hardware threads of the same physical core, including cpu
+    std::vector<int> smt_siblings;
+};
+
+
+class CpuTopology
+{
+
+public:
+
+    enum class Placement {
+        // one thread per physical core, round robin over LLC then L2 domains to maximize cache and bandwidth
+        SPREAD_CORES,
+        // all threads inside the LLC domain with the most usable cpus, cores before SMT siblings
+        PACK_LLC,
+        // one thread per physical core in cpu order, the set holds every sibling of that core
+        AVOID_SMT_SIBLINGS
+    };
+
+    // online cpus in EffectiveCpus()
+    static CpuTopology Load(const std::string& sysfs_root = "/sys/devices/system/cpu");
+
+    const std::vector<CpuInfo>& Cpus() const;
+
+    unsigned int PhysicalCores() const;
+
+    unsigned int LlcDomains() const;
+
+    // one cpu set per thread, wraps around when num_threads exceeds what the policy can keep apart
+    std::vector<cpu_set_t> Place(Placement placement, unsigned int num_threads) const;
+
+    // cpus in both the calling thread's affinity mask and the cgroup v2 cpuset.cpus.effective
+    static cpu_set_t EffectiveCpus();
+
+    // cgroup v2 cpu.max quota / period in cpus, the tightest over the process cgroup and its ancestors
+    // - 0 when there is no quota or no cgroup v2 mount
+    static double CpuQuota();
+
+    // threads worth running : EffectiveCpus() count capped by ceil(CpuQuota()), at least 1
+    // - size thread collections with this instead of std::thread::hardware_concurrency(), which counts every
+    //   online cpu and over-subscribes a container that only gets a cpuset slice or a quota
+    static unsigned int EffectiveConcurrency();
+
+    // pin target for thread idx : the (idx modulo count)th cpu of EffectiveCpus()
+    static unsigned int EffectiveCpu(unsigned int idx);
+
+    // "0-3,8,10-11" <-> {0,1,2,3,8,10,11}
+    static std::vector<int> ParseCpuList(const std::string& cpu_list);
+    static std::string FormatCpuList(const cpu_set_t& cpus);
+
+private:
+
+    // hardware threads grouped per physical core
+    struct Core
+    {
+        int package_id;
+        int core_id;
+        int l2_domain;
+        int llc_domain;
+        std::vector<int> cpus;
+    };
+
+    std::vector<cpu_set_t> SpreadCores(unsigned int num_threads) const;
+    std::vector<cpu_set_t> PackLlc(unsigned int num_threads) const;
+    std::vector<cpu_set_t> AvoidSmtSiblings(unsigned int num_threads) const;
+
+    std::vector<CpuInfo> cpus_;
+    std::vector<Core> cores_;
+};
@@ -0,0 +1,226 @@
+#include "EpochReclaimer.h"
+
+#include "LinuxThread.h"
+
+#include <thread>
+
+namespace {
+
+// record of the calling thread, released by ThreadExit()
+thread_local void* local_record{nullptr};
+
+// fallback for threads that are not LinuxThreads
+struct ExitNotifier
+{
+    ~ExitNotifier()
+    {
+        if (local_record) EpochReclaimer::GetReclaimer()->ThreadExit();
+    }
+};
+
+thread_local ExitNotifier exit_notifier;
+
+constexpr uint64_t kPinned = 1;
+
+}
+
+
+EpochReclaimer::Guard::Guard()
+{
+    EpochReclaimer::GetReclaimer()->Enter();
+}
+
+
+EpochReclaimer::Guard::~Guard()
+{
+    EpochReclaimer::GetReclaimer()->Leave();
+}
+
+
+EpochReclaimer* EpochReclaimer::GetReclaimer()
+{
+    static EpochReclaimer* reclaimer = new EpochReclaimer;
+    return reclaimer;
+}
+
+
+EpochReclaimer::EpochReclaimer()
+{
+    LinuxThread::AtExit([]() { GetReclaimer()->ThreadExit(); });
+}
+
+
+void EpochReclaimer::Enter()
+{
+    Record* record = LocalRecord();
+    if (record->depth++) return;
+
+    record->state.store(epoch_.load(std::memory_order_relaxed) << 1 | kPinned, std::memory_order_relaxed);
+    // the pin is visible before any shared pointer is read (pairs with the fence in TryAdvance)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+
+void EpochReclaimer::Leave()
+{
+    Record* record = LocalRecord();
+    if (--record->depth) return;
+    record->state.store(record->state.load(std::memory_order_relaxed) & ~kPinned, std::memory_order_release);
+}
+
+
+void EpochReclaimer::Retire(void* ptr, void (*deleter)(void*))
+{
+    Record* record = LocalRecord();
+    record->limbo.push_back({ptr, deleter, epoch_.load(std::memory_order_acquire)});
+    record->retired.store(record->retired.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    record->pending.store(record->limbo.size(), std::memory_order_relaxed);
+
+    if (++record->since_collect >= kCollectEvery) {
+        record->since_collect = 0;
+        TryAdvance();
+        Collect(record);
+    }
+}
+
+
+void EpochReclaimer::Quiescent()
+{
+    Record* record = LocalRecord();
+    if (record->depth) {
+        // nothing read before this point is still referenced, move the pin forward
+        record->state.store(epoch_.load(std::memory_order_relaxed) << 1 | kPinned, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    TryAdvance();
+    Collect(record);
+}
+
+
+void EpochReclaimer::Barrier()
+{
+    Record* record = LocalRecord();
+    uint64_t target = epoch_.load(std::memory_order_acquire) + 2;
+    while (epoch_.load(std::memory_order_acquire) < target) {
+        if (!TryAdvance()) std::this_thread::yield();
+    }
+    Collect(record);
+}
+
+
+void EpochReclaimer::ThreadExit()
+{
+    Record* record = static_cast<Record*>(local_record);
+    if (!record) return;
+    local_record = nullptr;
+
+    record->depth = 0;
+    record->state.store(0, std::memory_order_release);
+    if (!record->limbo.empty()) {
+        std::lock_guard<std::mutex> lck (orphan_mtx_);
+        for (auto& retired : record->limbo) orphans_.push_back(retired);
+        orphan_count_.store(orphans_.size(), std::memory_order_release);
+    }
+    // freed nodes stay counted, pending ones now belong to the orphans
+    record->retired.store(record->retired.load(std::memory_order_relaxed) - record->limbo.size(), std::memory_order_relaxed);
+    record->limbo.clear();
+    record->pending.store(0, std::memory_order_relaxed);
+    record->since_collect = 0;
+    record->in_use.store(false, std::memory_order_release);
+}
+
+
+EpochReclaimer::ReclaimStats EpochReclaimer::Stats() const
+{
+    ReclaimStats stats{epoch_.load(std::memory_order_relaxed), 0, orphans_freed_.load(std::memory_order_relaxed),
+        orphan_count_.load(std::memory_order_relaxed), 0};
+    stats.retired = stats.freed + stats.pending;
+    for (Record* record = records_.load(std::memory_order_acquire); record; record = record->next) {
+        stats.retired += record->retired.load(std::memory_order_relaxed);
+        stats.freed += record->freed.load(std::memory_order_relaxed);
+        stats.pending += record->pending.load(std::memory_order_relaxed);
+        if (record->in_use.load(std::memory_order_relaxed)) stats.threads++;
+    }
+    return stats;
+}
+
+
+EpochReclaimer::Record* EpochReclaimer::LocalRecord()
+{
+    if (local_record) return static_cast<Record*>(local_record);
+
+    // touch the thread_local so its destructor is registered for this thread
+    (void)&exit_notifier;
+
+    Record* record = nullptr;
+    for (Record* candidate = records_.load(std::memory_order_acquire); candidate; candidate = candidate->next) {
+        bool expected = false;
+        if (!candidate->in_use.load(std::memory_order_relaxed)
+            && candidate->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            record = candidate;
+            break;
+        }
+    }
+
+    if (!record) {
+        // records are never freed, an exited thread's record is reused by the next one
+        record = new Record;
+        record->in_use.store(true, std::memory_order_relaxed);
+        Record* head = records_.load(std::memory_order_relaxed);
+        do {
+            record->next = head;
+        } while (!records_.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    local_record = record;
+    return record;
+}
+
+
+bool EpochReclaimer::TryAdvance()
+{
+    uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    for (Record* record = records_.load(std::memory_order_acquire); record; record = record->next) {
+        // acquire : the reads a pinned thread made before Leave() happen before the advance
+        uint64_t state = record->state.load(std::memory_order_acquire);
+        if ((state & kPinned) && (state >> 1) != epoch) return false;
+    }
+
+    return epoch_.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+}
+
+
+void EpochReclaimer::Collect(Record* record)
+{
+    uint64_t safe = epoch_.load(std::memory_order_acquire) - 2;
+    FreeUpTo(record->limbo, safe, record);
+    record->pending.store(record->limbo.size(), std::memory_order_relaxed);
+    if (orphan_count_.load(std::memory_order_acquire)) CollectOrphans();
+}
+
+
+void EpochReclaimer::CollectOrphans()
+{
+    std::unique_lock<std::mutex> lck (orphan_mtx_, std::try_to_lock);
+    if (!lck.owns_lock()) return;
+
+    std::size_t before = orphans_.size();
+    FreeUpTo(orphans_, epoch_.load(std::memory_order_acquire) - 2, nullptr);
+    orphans_freed_.fetch_add(before - orphans_.size(), std::memory_order_relaxed);
+    orphan_count_.store(orphans_.size(), std::memory_order_release);
+}
+
+
+void EpochReclaimer::FreeUpTo(std::deque<Retired>& retired, uint64_t epoch, Record* record)
+{
+    // retire order is epoch order, free the safe prefix
+    uint64_t freed{0};
+    while (!retired.empty() && retired.front().epoch <= epoch) {
+        retired.front().deleter(retired.front().ptr);
+        retired.pop_front();
+        freed++;
+    }
+    if (record && freed) record->freed.store(record->freed.load(std::memory_order_relaxed) + freed, std::memory_order_relaxed);
+}
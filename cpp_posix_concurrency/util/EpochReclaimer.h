@@ -0,0 +1,138 @@
+#pragma once
+
+#include "CacheLine.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// epoch based reclamation (Fraser) for lock-free structures
+// - readers run inside a Guard : the thread is pinned to the global epoch it saw on entry
+// - a writer unlinks a node, then Retire()s it : the node goes on the calling thread's deferred free list
+//   tagged with the current epoch
+// - the global epoch only advances once every pinned thread has seen it, a node retired in epoch e is
+//   freed once the global epoch reaches e + 2 (no guard that could still see it is left)
+// - Quiescent() : the calling thread declares it holds no references, it re-pins to the current epoch
+//   (when inside a guard), helps advance and frees its own safe nodes. Long running loops call it once
+//   per iteration instead of holding one guard forever
+// - threads register on first use. A LinuxThread hands its unfreed nodes over on exit through
+//   LinuxThread::AtExit(), other threads through a thread_local destructor
+// - one pinned reader that never leaves stops all reclamation, see HazardPointers for long running readers
+//
+// {
+//     EpochReclaimer::Guard guard;
+//     for (Node* node = head.load(std::memory_order_acquire); node; node = node->next.load(std::memory_order_acquire)) ...
+// }
+// EpochReclaimer::GetReclaimer()->Retire(unlinked);
+
+class EpochReclaimer
+{
+
+public:
+
+    struct ReclaimStats
+    {
+        uint64_t epoch;
+        uint64_t retired;
+        uint64_t freed;
+        std::size_t pending;
+        std::size_t threads;
+    };
+
+    // pins the calling thread for its scope, nests
+    class Guard
+    {
+
+    public:
+
+        Guard();
+        ~Guard();
+
+        // Delete the copy constructor
+        Guard(const Guard&) = delete;
+
+        // Delete the Assignment opeartor
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    // process wide domain, never destroyed (threads may exit during static destruction)
+    static EpochReclaimer* GetReclaimer();
+
+    // Delete the copy constructor
+    EpochReclaimer(const EpochReclaimer&) = delete;
+
+    // Delete the Assignment opeartor
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+    void Enter();
+    void Leave();
+
+    // ptr must already be unreachable for new readers
+    template <typename T>
+    void Retire(T* ptr)
+    {
+        Retire(ptr, [](void* object) { delete static_cast<T*>(object); });
+    }
+
+    void Retire(void* ptr, void (*deleter)(void*));
+
+    void Quiescent();
+
+    // free everything retired so far, waits for the threads pinned right now to leave, must not be
+    // called inside a guard
+    void Barrier();
+
+    // hand the calling thread's record and unfreed nodes back, runs automatically on thread exit
+    void ThreadExit();
+
+    ReclaimStats Stats() const;
+
+private:
+
+    // try to advance the epoch every kCollectEvery retires
+    static constexpr std::size_t kCollectEvery = 64;
+
+    struct Retired
+    {
+        void* ptr;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    struct alignas(kCacheLineSize) Record
+    {
+        // epoch << 1 | pinned, read by every advancing thread
+        std::atomic<uint64_t> state{0};
+        std::atomic<bool> in_use{false};
+        // immutable once the record is published
+        Record* next{nullptr};
+
+        // owner only
+        unsigned int depth{0};
+        std::size_t since_collect{0};
+        std::deque<Retired> limbo;
+        std::atomic<uint64_t> retired{0};
+        std::atomic<uint64_t> freed{0};
+        std::atomic<std::size_t> pending{0};
+    };
+
+    EpochReclaimer();
+
+    Record* LocalRecord();
+    bool TryAdvance();
+    void Collect(Record* record);
+    void CollectOrphans();
+    void FreeUpTo(std::deque<Retired>& retired, uint64_t epoch, Record* record);
+
+    std::atomic<uint64_t> epoch_{2};
+    std::atomic<Record*> records_{nullptr};
+
+    // nodes of exited threads
+    std::mutex orphan_mtx_;
+    std::deque<Retired> orphans_;
+    std::atomic<std::size_t> orphan_count_{0};
+    std::atomic<uint64_t> orphans_freed_{0};
+};
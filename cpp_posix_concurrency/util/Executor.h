@@ -0,0 +1,28 @@
+#pragma once
+
+#include <functional>
+
+// where continuations and submitted tasks run
+
+class Executor
+{
+
+public:
+
+    virtual ~Executor() = default;
+
+    virtual void Execute(std::function<void()> task) = 0;
+};
+
+
+// runs the task on the calling thread
+class InlineExecutor : public Executor
+{
+
+public:
+
+    void Execute(std::function<void()> task) override
+    {
+        task();
+    }
+};
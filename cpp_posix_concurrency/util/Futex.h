@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// thin wrappers over the futex syscall on a process private 32 bit word, plus a spin loop hint
+
+// sleep while *word == expected, returns on wake, signal or a changed value (callers recheck)
+inline void FutexWait(std::atomic<uint32_t>* word, uint32_t expected, const timespec* timeout = nullptr)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+// wake up to count waiters, returns how many were woken
+inline int FutexWake(std::atomic<uint32_t>* word, int count = 1)
+{
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+// busy wait hint : pause on x86 (frees the pipeline for the SMT sibling), yield on arm
+inline void CpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
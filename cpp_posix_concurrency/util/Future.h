@@ -0,0 +1,386 @@
+#pragma once
+
+#include "Executor.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// promise / future with continuations
+// - the shared state is one make_shared allocation holding value, error and continuation, a continuation whose
+//   captures outgrow std::function's small buffer (Then() captures a promise and the callable) allocates again
+// - Then() attaches a continuation that runs on an Executor once the value is ready, nothing blocks
+// - WhenAll() / WhenAny() combine futures without a waiting thread
+// - a future has one consumer : Get() or Then() takes the value, the future is empty afterwards
+// - when the last copy of a promise goes away without a value the future fails with
+//   std::future_error(broken_promise), waiters and continuations never hang on it
+// - T must be a value type (no Future<void>, use a placeholder value)
+
+template <typename T>
+class Future;
+
+
+template <typename T>
+class FutureState
+{
+
+public:
+
+    void SetValue(T value)
+    {
+        Complete([&]() { value_.emplace(std::move(value)); });
+    }
+
+    void SetException(std::exception_ptr error)
+    {
+        Complete([&]() { error_ = error; });
+    }
+
+    // runs continuation on executor once ready, immediately if already ready
+    void OnReady(Executor& executor, std::function<void()> continuation)
+    {
+        {
+            std::lock_guard<std::mutex> lck (mtx_);
+            if (!ready_) {
+                executor_ = &executor;
+                continuation_ = std::move(continuation);
+                return;
+            }
+        }
+        executor.Execute(std::move(continuation));
+    }
+
+    bool Ready()
+    {
+        std::lock_guard<std::mutex> lck (mtx_);
+        return ready_;
+    }
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lck (mtx_);
+        ready_cv_.wait(lck, [this] { return ready_; });
+    }
+
+    // ready state only, rethrows a stored exception
+    T Take()
+    {
+        if (error_) std::rethrow_exception(error_);
+        return std::move(*value_);
+    }
+
+    std::exception_ptr Error() const
+    {
+        return error_;
+    }
+
+    // live Promise copies, the last one to go breaks a pending state
+    void AddPromise()
+    {
+        promises_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void ReleasePromise()
+    {
+        if (1 != promises_.fetch_sub(1, std::memory_order_acq_rel)) return;
+        {
+            // nobody is left to set it, only the check races with nothing
+            std::lock_guard<std::mutex> lck (mtx_);
+            if (ready_) return;
+        }
+        SetException(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+    }
+
+private:
+
+    template <typename Store>
+    void Complete(Store store)
+    {
+        std::function<void()> continuation;
+        Executor* executor{nullptr};
+        {
+            std::lock_guard<std::mutex> lck (mtx_);
+            if (ready_) throw std::logic_error("future already satisfied");
+            store();
+            ready_ = true;
+            continuation = std::move(continuation_);
+            executor = executor_;
+        }
+        ready_cv_.notify_all();
+        if (continuation) executor->Execute(std::move(continuation));
+    }
+
+    std::mutex mtx_;
+    std::condition_variable ready_cv_;
+    bool ready_{false};
+    std::optional<T> value_;
+    std::exception_ptr error_;
+    Executor* executor_{nullptr};
+    std::function<void()> continuation_;
+    std::atomic<std::size_t> promises_{0};
+};
+
+
+template <typename T>
+class Promise
+{
+
+public:
+
+    Promise() :
+        state_(std::make_shared<FutureState<T>>())
+    {
+        state_->AddPromise();
+    }
+
+    // copies share the state, continuations capture promises by value
+    Promise(const Promise& other) :
+        state_(other.state_)
+    {
+        if (state_) state_->AddPromise();
+    }
+
+    Promise(Promise&& other) noexcept :
+        state_(std::move(other.state_))
+    {
+    }
+
+    Promise& operator=(Promise other) noexcept
+    {
+        std::swap(state_, other.state_);
+        return *this;
+    }
+
+    // the last copy breaks an unsatisfied promise
+    ~Promise()
+    {
+        if (state_) state_->ReleasePromise();
+    }
+
+    Future<T> GetFuture()
+    {
+        return Future<T>(state_);
+    }
+
+    void SetValue(T value)
+    {
+        state_->SetValue(std::move(value));
+    }
+
+    void SetException(std::exception_ptr error)
+    {
+        state_->SetException(error);
+    }
+
+private:
+
+    std::shared_ptr<FutureState<T>> state_;
+};
+
+
+template <typename T>
+class Future
+{
+
+public:
+
+    Future() = default;
+
+    explicit Future(std::shared_ptr<FutureState<T>> state) :
+        state_(std::move(state))
+    {
+    }
+
+    bool Valid() const
+    {
+        return static_cast<bool>(state_);
+    }
+
+    bool Ready() const
+    {
+        return state_->Ready();
+    }
+
+    // blocking, for the edge of the program only
+    T Get()
+    {
+        std::shared_ptr<FutureState<T>> state = std::move(state_);
+        state->Wait();
+        return state->Take();
+    }
+
+    // continuation runs on executor once ready, Get() then returns without blocking
+    void OnReady(Executor& executor, std::function<void()> continuation)
+    {
+        state_->OnReady(executor, std::move(continuation));
+    }
+
+    // func(T) runs on executor when the value is ready, an exception skips func and propagates
+    template <typename F>
+    auto Then(Executor& executor, F func) -> Future<std::invoke_result_t<F, T>>
+    {
+        using U = std::invoke_result_t<F, T>;
+
+        Promise<U> promise;
+        Future<U> next = promise.GetFuture();
+        std::shared_ptr<FutureState<T>> state = std::move(state_);
+
+        FutureState<T>* antecedent = state.get();
+        antecedent->OnReady(executor, [state, promise, func = std::move(func)]() mutable {
+            if (state->Error()) {
+                promise.SetException(state->Error());
+                return;
+            }
+            try {
+                promise.SetValue(func(state->Take()));
+            } catch (...) {
+                promise.SetException(std::current_exception());
+            }
+        });
+        return next;
+    }
+
+private:
+
+    template <typename V>
+    friend Future<std::vector<V>> WhenAll(std::vector<Future<V>> futures);
+
+    template <typename V>
+    friend Future<std::pair<std::size_t, V>> WhenAny(std::vector<Future<V>> futures);
+
+    std::shared_ptr<FutureState<T>> state_;
+};
+
+
+template <typename T>
+Future<T> MakeReadyFuture(T value)
+{
+    Promise<T> promise;
+    promise.SetValue(std::move(value));
+    return promise.GetFuture();
+}
+
+
+// func() runs on executor
+template <typename F>
+auto Async(Executor& executor, F func) -> Future<std::invoke_result_t<F>>
+{
+    using U = std::invoke_result_t<F>;
+
+    Promise<U> promise;
+    Future<U> future = promise.GetFuture();
+    executor.Execute([promise, func = std::move(func)]() mutable {
+        try {
+            promise.SetValue(func());
+        } catch (...) {
+            promise.SetException(std::current_exception());
+        }
+    });
+    return future;
+}
+
+
+// ready when every input is ready, values in input order, the first exception wins
+template <typename T>
+Future<std::vector<T>> WhenAll(std::vector<Future<T>> futures)
+{
+    struct Join
+    {
+        std::mutex mtx;
+        std::vector<std::optional<T>> values;
+        std::size_t remaining;
+        std::exception_ptr error;
+        Promise<std::vector<T>> promise;
+    };
+
+    static InlineExecutor inline_executor;
+
+    auto join = std::make_shared<Join>();
+    join->values.resize(futures.size());
+    join->remaining = futures.size();
+    Future<std::vector<T>> all = join->promise.GetFuture();
+
+    if (futures.empty()) {
+        join->promise.SetValue({});
+        return all;
+    }
+
+    for (std::size_t idx = 0; idx < futures.size(); idx++) {
+        std::shared_ptr<FutureState<T>> state = std::move(futures[idx].state_);
+        FutureState<T>* input = state.get();
+        input->OnReady(inline_executor, [join, state, idx]() {
+            bool last;
+            {
+                std::lock_guard<std::mutex> lck (join->mtx);
+                if (state->Error()) {
+                    if (!join->error) join->error = state->Error();
+                } else {
+                    join->values[idx].emplace(state->Take());
+                }
+                last = (0 == --join->remaining);
+            }
+            if (!last) return;
+
+            if (join->error) {
+                join->promise.SetException(join->error);
+                return;
+            }
+            std::vector<T> values;
+            values.reserve(join->values.size());
+            for (auto& value : join->values) values.push_back(std::move(*value));
+            join->promise.SetValue(std::move(values));
+        });
+    }
+    return all;
+}
+
+
+// ready with the index and value of the first input to become ready, fails at once on no input
+template <typename T>
+Future<std::pair<std::size_t, T>> WhenAny(std::vector<Future<T>> futures)
+{
+    struct Race
+    {
+        std::mutex mtx;
+        bool done{false};
+        Promise<std::pair<std::size_t, T>> promise;
+    };
+
+    static InlineExecutor inline_executor;
+
+    auto race = std::make_shared<Race>();
+    Future<std::pair<std::size_t, T>> any = race->promise.GetFuture();
+
+    if (futures.empty()) {
+        race->promise.SetException(std::make_exception_ptr(std::invalid_argument("WhenAny() of no futures")));
+        return any;
+    }
+
+    for (std::size_t idx = 0; idx < futures.size(); idx++) {
+        std::shared_ptr<FutureState<T>> state = std::move(futures[idx].state_);
+        FutureState<T>* input = state.get();
+        input->OnReady(inline_executor, [race, state, idx]() {
+            {
+                std::lock_guard<std::mutex> lck (race->mtx);
+                if (race->done) return;
+                race->done = true;
+            }
+            if (state->Error()) {
+                race->promise.SetException(state->Error());
+            } else {
+                race->promise.SetValue(std::make_pair(idx, state->Take()));
+            }
+        });
+    }
+    return any;
+}
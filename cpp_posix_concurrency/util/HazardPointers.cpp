@@ -0,0 +1,198 @@
+#include "HazardPointers.h"
+
+#include "LinuxThread.h"
+#include "SyncLog.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// record of the calling thread, released by ThreadExit()
+thread_local void* local_record{nullptr};
+
+// fallback for threads that are not LinuxThreads
+struct ExitNotifier
+{
+    ~ExitNotifier()
+    {
+        if (local_record) HazardPointers::GetDomain()->ThreadExit();
+    }
+};
+
+thread_local ExitNotifier exit_notifier;
+
+}
+
+
+HazardPointers::Hazard::Hazard()
+{
+    Record* record = HazardPointers::GetDomain()->LocalRecord();
+    for (index_ = 0; index_ < kSlotsPerThread; index_++) {
+        if (0 == (record->used & (1u << index_))) break;
+    }
+    if (kSlotsPerThread == index_) {
+        SyncLog::GetLog()->Log("HazardPointers : more than kSlotsPerThread hazards on one thread");
+        std::abort();
+    }
+    record->used |= 1u << index_;
+    slot_ = &record->slots[index_];
+}
+
+
+HazardPointers::Hazard::~Hazard()
+{
+    Reset();
+    Record* record = static_cast<Record*>(local_record);
+    if (record) record->used &= ~(1u << index_);
+}
+
+
+HazardPointers* HazardPointers::GetDomain()
+{
+    static HazardPointers* domain = new HazardPointers;
+    return domain;
+}
+
+
+HazardPointers::HazardPointers()
+{
+    LinuxThread::AtExit([]() { GetDomain()->ThreadExit(); });
+}
+
+
+void HazardPointers::Retire(void* ptr, void (*deleter)(void*))
+{
+    Record* record = LocalRecord();
+    record->retired.push_back({ptr, deleter});
+    record->retired_count.store(record->retired_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    record->pending.store(record->retired.size(), std::memory_order_relaxed);
+
+    if (record->retired.size() >= ScanThreshold()) Scan();
+}
+
+
+void HazardPointers::Scan()
+{
+    Record* record = LocalRecord();
+    ScanList(record->retired, record);
+    record->pending.store(record->retired.size(), std::memory_order_relaxed);
+    record->scans.store(record->scans.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (orphan_count_.load(std::memory_order_acquire)) {
+        std::unique_lock<std::mutex> lck (orphan_mtx_, std::try_to_lock);
+        if (lck.owns_lock()) {
+            std::size_t before = orphans_.size();
+            ScanList(orphans_, nullptr);
+            orphans_freed_.fetch_add(before - orphans_.size(), std::memory_order_relaxed);
+            orphan_count_.store(orphans_.size(), std::memory_order_release);
+        }
+    }
+}
+
+
+void HazardPointers::ThreadExit()
+{
+    Record* record = static_cast<Record*>(local_record);
+    if (!record) return;
+
+    ScanList(record->retired, record);
+    if (!record->retired.empty()) {
+        std::lock_guard<std::mutex> lck (orphan_mtx_);
+        orphans_.insert(orphans_.end(), record->retired.begin(), record->retired.end());
+        orphan_count_.store(orphans_.size(), std::memory_order_release);
+    }
+    // freed nodes stay counted, pending ones now belong to the orphans
+    record->retired_count.store(record->retired_count.load(std::memory_order_relaxed) - record->retired.size(),
+        std::memory_order_relaxed);
+    record->retired.clear();
+    record->pending.store(0, std::memory_order_relaxed);
+
+    for (auto& slot : record->slots) slot.store(nullptr, std::memory_order_relaxed);
+    record->used = 0;
+    local_record = nullptr;
+    record->in_use.store(false, std::memory_order_release);
+}
+
+
+HazardPointers::ReclaimStats HazardPointers::Stats() const
+{
+    ReclaimStats stats{0, orphans_freed_.load(std::memory_order_relaxed), 0, orphan_count_.load(std::memory_order_relaxed), 0};
+    stats.retired = stats.freed + stats.pending;
+    for (Record* record = records_.load(std::memory_order_acquire); record; record = record->next) {
+        stats.retired += record->retired_count.load(std::memory_order_relaxed);
+        stats.freed += record->freed.load(std::memory_order_relaxed);
+        stats.scans += record->scans.load(std::memory_order_relaxed);
+        stats.pending += record->pending.load(std::memory_order_relaxed);
+        if (record->in_use.load(std::memory_order_relaxed)) stats.threads++;
+    }
+    return stats;
+}
+
+
+HazardPointers::Record* HazardPointers::LocalRecord()
+{
+    if (local_record) return static_cast<Record*>(local_record);
+
+    // touch the thread_local so its destructor is registered for this thread
+    (void)&exit_notifier;
+
+    Record* record = nullptr;
+    for (Record* candidate = records_.load(std::memory_order_acquire); candidate; candidate = candidate->next) {
+        bool expected = false;
+        if (!candidate->in_use.load(std::memory_order_relaxed)
+            && candidate->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            record = candidate;
+            break;
+        }
+    }
+
+    if (!record) {
+        // records are never freed, an exited thread's record is reused by the next one
+        record = new Record;
+        record->in_use.store(true, std::memory_order_relaxed);
+        Record* head = records_.load(std::memory_order_relaxed);
+        do {
+            record->next = head;
+        } while (!records_.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+        record_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    local_record = record;
+    return record;
+}
+
+
+std::size_t HazardPointers::ScanThreshold() const
+{
+    return std::max(kMinScan, 2 * kSlotsPerThread * record_count_.load(std::memory_order_relaxed));
+}
+
+
+void HazardPointers::ScanList(std::vector<Retired>& retired, Record* record)
+{
+    if (retired.empty()) return;
+
+    // every published hazard, the fence orders the unlink before the reads (pairs with Hazard::Set)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::vector<void*> hazards;
+    hazards.reserve(kSlotsPerThread * record_count_.load(std::memory_order_relaxed));
+    for (Record* candidate = records_.load(std::memory_order_acquire); candidate; candidate = candidate->next) {
+        for (auto& slot : candidate->slots) {
+            void* ptr = slot.load(std::memory_order_acquire);
+            if (ptr) hazards.push_back(ptr);
+        }
+    }
+    std::sort(hazards.begin(), hazards.end());
+
+    uint64_t freed{0};
+    auto kept = std::remove_if(retired.begin(), retired.end(), [&hazards, &freed](const Retired& node) {
+        if (std::binary_search(hazards.begin(), hazards.end(), node.ptr)) return false;
+        node.deleter(node.ptr);
+        freed++;
+        return true;
+    });
+    retired.erase(kept, retired.end());
+
+    if (record && freed) record->freed.store(record->freed.load(std::memory_order_relaxed) + freed, std::memory_order_relaxed);
+}
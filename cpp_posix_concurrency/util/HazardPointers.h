@@ -0,0 +1,154 @@
+#pragma once
+
+#include "CacheLine.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// hazard pointers (Michael) : reclamation that long running readers cannot stall
+// - a reader publishes each node it is about to dereference in a hazard slot, then checks that the node
+//   is still reachable, the node cannot be freed while the slot holds it
+// - Retire() puts a node on the calling thread's list, once the list is long enough a scan frees every
+//   retired node no slot holds. Unfreed memory stays bounded by the number of slots, whatever the readers do
+// - costs a store + full fence per node visited, EpochReclaimer is cheaper when readers are short
+// - kSlotsPerThread slots per thread, a Hazard owns one for its scope
+// - thread exit hands the retired list over to the domain (LinuxThread::AtExit(), thread_local otherwise)
+//
+// HazardPointers::Hazard hazard;
+// Node* node = hazard.Protect(head);
+// ... node stays valid until hazard.Reset() or the end of the scope
+
+class HazardPointers
+{
+
+public:
+
+    static constexpr std::size_t kSlotsPerThread = 4;
+
+    struct ReclaimStats
+    {
+        uint64_t retired;
+        uint64_t freed;
+        uint64_t scans;
+        std::size_t pending;
+        std::size_t threads;
+    };
+
+    // one hazard slot of the calling thread
+    class Hazard
+    {
+
+    public:
+
+        Hazard();
+        ~Hazard();
+
+        // Delete the copy constructor
+        Hazard(const Hazard&) = delete;
+
+        // Delete the Assignment opeartor
+        Hazard& operator=(const Hazard&) = delete;
+
+        // load src until the published value is still the current one
+        template <typename T>
+        T* Protect(const std::atomic<T*>& src)
+        {
+            T* ptr = src.load(std::memory_order_relaxed);
+            while (true) {
+                Set(ptr);
+                T* current = src.load(std::memory_order_acquire);
+                if (current == ptr) return ptr;
+                ptr = current;
+            }
+        }
+
+        // publish ptr, callers validate reachability afterwards themselves
+        void Set(const void* ptr)
+        {
+            slot_->store(const_cast<void*>(ptr), std::memory_order_release);
+            // published before the validating load (pairs with the fence in Scan)
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        void Reset()
+        {
+            slot_->store(nullptr, std::memory_order_release);
+        }
+
+    private:
+
+        std::atomic<void*>* slot_;
+        unsigned int index_;
+    };
+
+    // process wide domain, never destroyed (threads may exit during static destruction)
+    static HazardPointers* GetDomain();
+
+    // Delete the copy constructor
+    HazardPointers(const HazardPointers&) = delete;
+
+    // Delete the Assignment opeartor
+    HazardPointers& operator=(const HazardPointers&) = delete;
+
+    // ptr must already be unreachable for new readers
+    template <typename T>
+    void Retire(T* ptr)
+    {
+        Retire(ptr, [](void* object) { delete static_cast<T*>(object); });
+    }
+
+    void Retire(void* ptr, void (*deleter)(void*));
+
+    // free the calling thread's retired nodes that no slot holds
+    void Scan();
+
+    // hand the calling thread's record and unfreed nodes back, runs automatically on thread exit
+    void ThreadExit();
+
+    ReclaimStats Stats() const;
+
+private:
+
+    // scan once the retired list reaches max(kMinScan, 2 * all slots)
+    static constexpr std::size_t kMinScan = 64;
+
+    struct Retired
+    {
+        void* ptr;
+        void (*deleter)(void*);
+    };
+
+    struct alignas(kCacheLineSize) Record
+    {
+        std::atomic<void*> slots[kSlotsPerThread] = {};
+        std::atomic<bool> in_use{false};
+        // immutable once the record is published
+        Record* next{nullptr};
+
+        // owner only
+        unsigned int used{0};
+        std::vector<Retired> retired;
+        std::atomic<uint64_t> retired_count{0};
+        std::atomic<uint64_t> freed{0};
+        std::atomic<uint64_t> scans{0};
+        std::atomic<std::size_t> pending{0};
+    };
+
+    HazardPointers();
+
+    Record* LocalRecord();
+    std::size_t ScanThreshold() const;
+    void ScanList(std::vector<Retired>& retired, Record* record);
+
+    std::atomic<Record*> records_{nullptr};
+    std::atomic<std::size_t> record_count_{0};
+
+    // nodes of exited threads, scanned along with the next thread's scan
+    std::mutex orphan_mtx_;
+    std::vector<Retired> orphans_;
+    std::atomic<std::size_t> orphan_count_{0};
+    std::atomic<uint64_t> orphans_freed_{0};
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// move only std::function replacement that never allocates
+// - the callable is stored in Capacity bytes inside the object, a larger callable fails to compile
+//   (capture less, capture a pointer, or raise Capacity)
+// - moving moves the stored callable, the source is left empty
+// InplaceFunction<void(int), 32> func = [&total](int value) { total += value; };
+
+template <typename Signature, std::size_t Capacity = 64>
+class InplaceFunction;
+
+
+template <typename R, typename... Args, std::size_t Capacity>
+class InplaceFunction<R(Args...), Capacity>
+{
+
+public:
+
+    InplaceFunction() = default;
+
+    template <typename F, typename Callable = std::decay_t<F>,
+        typename = std::enable_if_t<!std::is_same_v<Callable, InplaceFunction> && std::is_invocable_r_v<R, Callable&, Args...>>>
+    InplaceFunction(F&& func)
+    {
+        static_assert(sizeof(Callable) <= Capacity, "callable does not fit the InplaceFunction capacity");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "over aligned callable");
+
+        ::new (static_cast<void*>(storage_)) Callable(std::forward<F>(func));
+        ops_ = &kOps<Callable>;
+    }
+
+    // Delete the copy constructor
+    InplaceFunction(const InplaceFunction&) = delete;
+
+    // Delete the Assignment opeartor
+    InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+    InplaceFunction(InplaceFunction&& obj) noexcept
+    {
+        if (obj.ops_) {
+            obj.ops_->move(storage_, obj.storage_);
+            ops_ = obj.ops_;
+            obj.ops_ = nullptr;
+        }
+    }
+
+    InplaceFunction& operator=(InplaceFunction&& obj) noexcept
+    {
+        if (this != &obj) {
+            Reset();
+            if (obj.ops_) {
+                obj.ops_->move(storage_, obj.storage_);
+                ops_ = obj.ops_;
+                obj.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    ~InplaceFunction()
+    {
+        Reset();
+    }
+
+    // destroy the stored callable
+    void Reset()
+    {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    explicit operator bool() const
+    {
+        return nullptr != ops_;
+    }
+
+    R operator()(Args... args)
+    {
+        return ops_->invoke(storage_, std::forward<Args>(args)...);
+    }
+
+private:
+
+    struct Ops
+    {
+        R (*invoke)(void* storage, Args&&... args);
+        // move construct into dst and destroy src
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void* storage);
+    };
+
+    template <typename Callable>
+    static constexpr Ops kOps = {
+        [](void* storage, Args&&... args) -> R {
+            return (*static_cast<Callable*>(storage))(std::forward<Args>(args)...);
+        },
+        [](void* dst, void* src) {
+            ::new (dst) Callable(std::move(*static_cast<Callable*>(src)));
+            static_cast<Callable*>(src)->~Callable();
+        },
+        [](void* storage) {
+            static_cast<Callable*>(storage)->~Callable();
+        }
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[Capacity];
+    const Ops* ops_{nullptr};
+};
@@ -0,0 +1,180 @@
+#include "LaneExecutor.h"
+
+#include "SyncLog.h"
+#include "ThreadAttributes.h"
+
+#include <sched.h>
+
+namespace {
+
+const char* policy_name(int policy)
+{
+    switch (policy) {
+        case SCHED_OTHER: return "SCHED_OTHER";
+        case SCHED_BATCH: return "SCHED_BATCH";
+        case SCHED_IDLE: return "SCHED_IDLE";
+        case SCHED_FIFO: return "SCHED_FIFO";
+        case SCHED_RR: return "SCHED_RR";
+        default: return "unknown";
+    }
+}
+
+}
+
+
+LaneExecutor::Lane::Lane(LaneConfig config) :
+    config_(std::move(config)),
+    queue_(config_.capacity)
+{
+}
+
+
+void LaneExecutor::Lane::Execute(std::function<void()> task)
+{
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    if (!queue_.Push(std::move(task))) {
+        submitted_.fetch_sub(1, std::memory_order_relaxed);
+        SyncLog::GetLog()->Log("lane " + config_.name + " closed, task dropped");
+    }
+}
+
+
+LaneExecutor::LaneExecutor(std::vector<LaneConfig> lanes)
+{
+    unsigned int num_workers{0};
+    for (auto& config : lanes) {
+        if (0 == config.workers) config.workers = 1;
+        num_workers += config.workers;
+        lanes_.emplace_back(new Lane(std::move(config)));
+    }
+
+    threads_.reserve(num_workers);
+    for (auto& lane : lanes_) {
+        const LaneConfig& config = lane->config_;
+        bool realtime = (SCHED_FIFO == config.policy || SCHED_RR == config.policy);
+
+        // the lane's scheduling class is in effect before a worker takes its first task
+        ThreadAttributes attributes = ThreadAttributes().Policy(config.policy).Affinity(LinuxThread::CpuSet(config.affinity));
+        if (realtime) {
+            attributes.Priority(config.priority);
+        } else {
+            attributes.Nice(config.priority);
+        }
+
+        for (unsigned int idx = 0; idx < config.workers; idx++) {
+            Lane* worker_lane = lane.get();
+            threads_.emplace_back([this, worker_lane](std::string) { WorkerLoop(*worker_lane); },
+                config.name + "_" + std::to_string(idx), attributes);
+        }
+    }
+}
+
+
+LaneExecutor::~LaneExecutor()
+{
+    // workers drain their closed lane, then return
+    for (auto& lane : lanes_) lane->queue_.Close();
+    for (auto& thread : threads_) thread.Join();
+}
+
+
+int LaneExecutor::LaneIndex(const std::string& name) const
+{
+    for (std::size_t idx = 0; idx < lanes_.size(); idx++) {
+        if (lanes_[idx]->config_.name == name) return static_cast<int>(idx);
+    }
+    return -1;
+}
+
+
+LaneExecutor::Lane& LaneExecutor::GetLane(std::size_t lane)
+{
+    return *lanes_[lane];
+}
+
+
+LaneExecutor::Lane& LaneExecutor::GetLane(const std::string& name)
+{
+    int idx = LaneIndex(name);
+    if (idx < 0) {
+        SyncLog::GetLog()->Log("no lane " + name + ", using lane " + lanes_.front()->config_.name);
+        idx = 0;
+    }
+    return *lanes_[idx];
+}
+
+
+void LaneExecutor::Submit(std::size_t lane, std::function<void()> task)
+{
+    lanes_[lane]->Execute(std::move(task));
+}
+
+
+void LaneExecutor::Submit(const std::string& lane, std::function<void()> task)
+{
+    int idx = LaneIndex(lane);
+    if (idx < 0) {
+        SyncLog::GetLog()->Log("no lane " + lane + ", task dropped");
+        return;
+    }
+    Submit(static_cast<std::size_t>(idx), std::move(task));
+}
+
+
+bool LaneExecutor::TrySubmit(std::size_t lane, std::function<void()> task)
+{
+    Lane& target = *lanes_[lane];
+    if (!target.queue_.TryPush(std::move(task))) return false;
+    target.submitted_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+
+void LaneExecutor::Execute(std::function<void()> task)
+{
+    Submit(std::size_t{0}, std::move(task));
+}
+
+
+std::size_t LaneExecutor::LaneCount() const
+{
+    return lanes_.size();
+}
+
+
+std::vector<LaneExecutor::LaneStats> LaneExecutor::Stats() const
+{
+    std::vector<LaneStats> stats;
+    for (auto& lane : lanes_) {
+        const LaneConfig& config = lane->config_;
+        stats.push_back({config.name, config.policy, config.priority, config.workers,
+            lane->submitted_.load(std::memory_order_relaxed), lane->completed_.load(std::memory_order_relaxed),
+            lane->queue_.Size(), lane->queue_.Capacity()});
+    }
+    return stats;
+}
+
+
+void LaneExecutor::Report() const
+{
+    for (auto& lane : Stats()) {
+        SyncLog::GetLog()->Log("lane " + lane.name
+            + " : " + policy_name(lane.policy) + " " + std::to_string(lane.priority)
+            + ", workers " + std::to_string(lane.workers)
+            + ", submitted " + std::to_string(lane.submitted)
+            + ", completed " + std::to_string(lane.completed)
+            + ", depth " + std::to_string(lane.depth) + "/" + std::to_string(lane.capacity));
+    }
+}
+
+
+void LaneExecutor::WorkerLoop(Lane& lane)
+{
+    std::function<void()> task;
+    while (lane.queue_.Pop(task)) {
+        task();
+        // release the captures before parking
+        task = nullptr;
+        lane.completed_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Executor.h"
+#include "LinuxThread.h"
+#include "MpmcQueue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// executor with named lanes, each lane served by its own workers under its own scheduling class
+// - tasks are submitted to a lane, not to a thread : latency critical work on a SCHED_FIFO lane,
+//   bulk work on SCHED_BATCH, housekeeping on SCHED_IDLE, the kernel then arbitrates between lanes
+//   sharing cpus and no thread is spawned per task
+// - a lane is a bounded MpmcQueue, a full lane blocks Submit() (backpressure), TrySubmit() fails instead
+// - without the privilege for a realtime policy the lane's workers inherit the creator's scheduling
+//   (logged by LinuxThread)
+//
+// LaneExecutor lanes({{"request", SCHED_FIFO, 10, 2}, {"bulk", SCHED_BATCH, 10, 2}, {"housekeeping", SCHED_IDLE, 0, 1}});
+// lanes.Submit("bulk", [] { Compact(); });
+
+class LaneExecutor : public Executor
+{
+
+public:
+
+    // - CFS policies (SCHED_OTHER, SCHED_BATCH, SCHED_IDLE) : priority is the niceness
+    // - realtime policies (SCHED_FIFO, SCHED_RR) : priority is the sched_priority
+    // - affinity pins every worker of the lane to one cpu, the unsigned -1 default leaves them unpinned
+    struct LaneConfig
+    {
+        std::string name;
+        int policy;
+        int priority;
+        unsigned int workers{1};
+        unsigned int affinity = -1;
+        std::size_t capacity{1024};
+    };
+
+    struct LaneStats
+    {
+        std::string name;
+        int policy;
+        int priority;
+        unsigned int workers;
+        uint64_t submitted;
+        uint64_t completed;
+        std::size_t depth;
+        std::size_t capacity;
+    };
+
+    // one lane as an Executor, e.g. for Future::Then() or CoroScheduler continuations
+    class Lane : public Executor
+    {
+
+    public:
+
+        void Execute(std::function<void()> task) override;
+
+    private:
+
+        friend class LaneExecutor;
+
+        Lane(LaneConfig config);
+
+        LaneConfig config_;
+        MpmcQueue<std::function<void()>> queue_;
+        std::atomic<uint64_t> submitted_{0};
+        std::atomic<uint64_t> completed_{0};
+    };
+
+    // Delete the copy constructor
+    LaneExecutor(const LaneExecutor&) = delete;
+
+    // Delete the Assignment opeartor
+    LaneExecutor& operator=(const LaneExecutor&) = delete;
+
+    explicit LaneExecutor(std::vector<LaneConfig> lanes);
+
+    // runs the tasks already queued, then joins the workers
+    ~LaneExecutor();
+
+    // index of the lane called name, -1 when there is none
+    int LaneIndex(const std::string& name) const;
+
+    // a missing lane name is logged and falls back to the first lane
+    Lane& GetLane(std::size_t lane);
+    Lane& GetLane(const std::string& name);
+
+    // blocks while the lane is full, a missing lane name is logged and the task dropped
+    void Submit(std::size_t lane, std::function<void()> task);
+    void Submit(const std::string& lane, std::function<void()> task);
+
+    // false when the lane is full
+    bool TrySubmit(std::size_t lane, std::function<void()> task);
+
+    // Executor, submits to the first lane
+    void Execute(std::function<void()> task) override;
+
+    std::size_t LaneCount() const;
+
+    std::vector<LaneStats> Stats() const;
+
+    // one SyncLog line per lane
+    void Report() const;
+
+private:
+
+    void WorkerLoop(Lane& lane);
+
+    std::vector<std::unique_ptr<Lane>> lanes_;
+    std::vector<LinuxThread> threads_;
+};
@@ -6,88 +6,480 @@
 
 #include "LinuxThread.h"
 
+#include <algorithm>
 #include <cstring>
 #include <errno.h>
+#include <iterator>
+#include <linux/perf_event.h>
+#include <mutex>
+#include <new>
+#include <signal.h>
 #include <sys/syscall.h>
 #include <unistd.h>
+#include <utility>
 
+#include "RealTimeMemory.h"
 #include "SyncLog.h"
 
+#ifndef SCHED_FLAG_DL_OVERRUN
+#define SCHED_FLAG_DL_OVERRUN 0x04
+#endif
 
-LinuxThread::LinuxThread(std::function<void()> func, unsigned int affinity) :
-    thread_(func)
+namespace {
+
+// kernel ABI of sched_setattr(2), glibc provides no wrapper
+struct sched_attr_dl
+{
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
+// overrun counter of the calling deadline thread, read from the SIGXCPU handler
+thread_local std::atomic<uint64_t>* deadline_overruns{nullptr};
+
+// SIGXCPU taken by a thread that is not a deadline LinuxThread
+std::atomic<uint64_t> stray_sigxcpu{0};
+
+// the application's handler from before set_deadline() installed ours
+struct sigaction previous_sigxcpu{};
+
+// the kernel sends the overrun SIGXCPU process directed, it lands on the overrunning thread when that
+// thread is running and does not block it, otherwise on any thread
+void sigxcpu_handler(int sig, siginfo_t* info, void* context)
 {
+    if (deadline_overruns) {
+        deadline_overruns->fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    stray_sigxcpu.fetch_add(1, std::memory_order_relaxed);
+    // not ours to count (or e.g. RLIMIT_CPU), chain to the previous handler
+    if (previous_sigxcpu.sa_flags & SA_SIGINFO) {
+        if (previous_sigxcpu.sa_sigaction) previous_sigxcpu.sa_sigaction(sig, info, context);
+    } else if (SIG_DFL != previous_sigxcpu.sa_handler && SIG_IGN != previous_sigxcpu.sa_handler) {
+        previous_sigxcpu.sa_handler(sig);
+    }
 }
 
-LinuxThread::LinuxThread(std::function<void(std::string)> func, std::string name, unsigned int affinity) :
-    name_(name),
-    affinity_(affinity),
-    thread_(func, name)
-{
-    sched_param scheduler;
-    int policy; 
-
-    if (affinity >= 0) {
-        cpu_set_t cpuset;
-        CPU_ZERO(&cpuset);
-        CPU_SET(affinity, &cpuset);
-        int rc = pthread_setaffinity_np(thread_.native_handle(), sizeof(cpu_set_t), &cpuset);
-        if (rc != 0) {
-            SyncLog::GetLog()->Log("Error calling pthread_setaffinity_np: " + std::to_string(rc));
-        }
+int set_deadline(const ThreadAttributes::DeadlineParams& params)
+{
+    // installed once by the first deadline thread, keeps the previous handler for chaining
+    static bool installed = []() {
+        struct sigaction action{};
+        action.sa_sigaction = sigxcpu_handler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        return 0 == sigaction(SIGXCPU, &action, &previous_sigxcpu);
+    }();
+    (void)installed;
+
+    sched_attr_dl attr{};
+    attr.size = sizeof(attr);
+    attr.sched_policy = SCHED_DEADLINE;
+    attr.sched_flags = SCHED_FLAG_DL_OVERRUN;
+    attr.sched_runtime = params.runtime_ns;
+    attr.sched_deadline = params.deadline_ns;
+    attr.sched_period = params.period_ns;
+    return syscall(SYS_sched_setattr, 0, &attr, 0);
+}
+
+// ThreadCounters order
+constexpr std::pair<uint32_t, uint64_t> perf_events[] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+// counter on the calling thread, any cpu, -1 on failure
+int open_perf_counter(uint32_t type, uint64_t config)
+{
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    int fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0 && (EACCES == errno || EPERM == errno)) {
+        // perf_event_paranoid 2 : user space only
+        attr.exclude_kernel = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
     }
+    return fd;
 }
 
+int64_t read_perf_counter(int fd)
+{
+    if (fd < 0) return -1;
+
+    // value, time enabled, time running
+    uint64_t values[3];
+    if (sizeof(values) != read(fd, values, sizeof(values))) return -1;
+    if (0 == values[2]) return 0;
+    if (values[2] < values[1]) return static_cast<int64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+    return values[0];
+}
+
+// recycled ThreadState storage, a free list threaded through idle entries
+// - grown a chunk at a time and never returned, steady state spawning does not touch the heap
+struct StatePool
+{
+    struct Node
+    {
+        Node* next;
+    };
+
+    static constexpr std::size_t kChunk = 64;
+
+    std::mutex mtx;
+    Node* free{nullptr};
+    std::size_t idle{0};
+};
+
+// leaked on purpose, threads may still release entries during static destruction
+StatePool& state_pool()
+{
+    static StatePool* pool = new StatePool;
+    return *pool;
+}
+
+// LinuxThread::AtExit() hooks, slots are filled once and never cleared
+std::atomic<void (*)()> exit_hooks[LinuxThread::kMaxExitHooks];
+
+}
+
+
+LinuxThread::LinuxThread(Function func, unsigned int affinity) :
+    LinuxThread(std::move(func), CpuSet(affinity))
+{
+}
+
+
+LinuxThread::LinuxThread(Function func, const cpu_set_t& cpus) :
+    LinuxThread(std::move(func), ThreadAttributes().Affinity(cpus))
+{
+}
 
-LinuxThread::LinuxThread(std::function<void(std::string, int, int)> func, std::string name, int policy, int priority, unsigned int affinity) :
+
+LinuxThread::LinuxThread(Function func, const ThreadAttributes& attributes)
+{
+    Start(std::move(func), attributes);
+}
+
+
+LinuxThread::LinuxThread(NamedFunction func, ThreadName name, unsigned int affinity) :
+    LinuxThread(std::move(func), name, CpuSet(affinity))
+{
+}
+
+
+LinuxThread::LinuxThread(NamedFunction func, ThreadName name, const cpu_set_t& cpus) :
+    LinuxThread(std::move(func), name, ThreadAttributes().Affinity(cpus))
+{
+}
+
+
+LinuxThread::LinuxThread(NamedFunction func, ThreadName name, const ThreadAttributes& attributes) :
+    name_(name)
+{
+    // a 15 character name stays within the std::string small buffer
+    Start([func = std::move(func), name]() mutable { func(name.c_str()); }, attributes);
+}
+
+
+LinuxThread::LinuxThread(SchedFunction func, ThreadName name, int policy, int priority, unsigned int affinity) :
+    LinuxThread(std::move(func), name, policy, priority, CpuSet(affinity))
+{
+}
+
+
+LinuxThread::LinuxThread(SchedFunction func, ThreadName name, int policy, int priority, const cpu_set_t& cpus) :
     name_(name),
-    thread_(func, name, policy, priority)
-{
-    sched_param scheduler;
-    int current_policy; 
-
-    if (affinity >= 0) {
-        cpu_set_t cpuset;
-        CPU_ZERO(&cpuset);
-        CPU_SET(affinity, &cpuset);
-        int rc = pthread_setaffinity_np(thread_.native_handle(), sizeof(cpu_set_t), &cpuset);
-        if (rc != 0) {
-            SyncLog::GetLog()->Log("Error calling pthread_setaffinity_np: " + std::to_string(rc));
-        }
-    }
+    policy_(policy),
+    priority_(priority)
+{
+    Start([func = std::move(func), name, policy, priority]() mutable { func(name.c_str(), policy, priority); },
+        ThreadAttributes().Policy(policy).Priority(priority).Affinity(cpus));
 }
 
 
-LinuxThread::LinuxThread(LinuxThread && obj) : 
-    thread_(std::move(obj.thread_))
+LinuxThread::LinuxThread(LinuxThread && obj) noexcept :
+    thread_(obj.thread_),
+    state_(std::exchange(obj.state_, nullptr)),
+    joinable_(std::exchange(obj.joinable_, false)),
+    name_(obj.name_),
+    policy_(obj.policy_),
+    priority_(obj.priority_),
+    cpus_(obj.cpus_)
 {
-    std::cout << "Move Constructor is called" << std::endl;
 }
 
 
-LinuxThread & LinuxThread::operator=(LinuxThread && obj)
+LinuxThread & LinuxThread::operator=(LinuxThread && obj) noexcept
 {
-    std::cout << "Move Assignment is called" << std::endl;
-    if (thread_.joinable())
-        thread_.join();
-    thread_ = std::move(obj.thread_);
+    if (this != &obj) {
+        if (joinable_) Join();
+        if (state_) ReleaseState(state_);
+
+        thread_ = obj.thread_;
+        state_ = std::exchange(obj.state_, nullptr);
+        joinable_ = std::exchange(obj.joinable_, false);
+        name_ = obj.name_;
+        policy_ = obj.policy_;
+        priority_ = obj.priority_;
+        cpus_ = obj.cpus_;
+    }
     return *this;
 }
 
 
-void LinuxThread::ThreadInfo()
+LinuxThread::~LinuxThread()
 {
+    if (joinable_) Join();
+    if (state_) ReleaseState(state_);
+}
+
+
+ThreadCounters LinuxThread::ThreadInfo() const
+{
+    ThreadCounters counters;
+    if (!state_) return counters;
+
+    int64_t* values[] = {&counters.cycles, &counters.instructions, &counters.cache_misses,
+        &counters.context_switches, &counters.cpu_migrations, &counters.page_faults};
+    for (std::size_t idx = 0; idx < std::size(values); idx++) {
+        *values[idx] = read_perf_counter(state_->perf_fds[idx].load(std::memory_order_acquire));
+    }
+    return counters;
+}
+
+
+pid_t LinuxThread::Tid() const
+{
+    return state_ ? state_->tid.load(std::memory_order_acquire) : 0;
+}
+
 
+const char* LinuxThread::Name() const
+{
+    return name_.c_str();
 }
 
 
 bool LinuxThread::Joinable()
 {
-    return thread_.joinable();
+    return joinable_;
 }
 
 
 void LinuxThread::Join()
 {
-    thread_.join();
+    // a failed pthread_create() left no thread behind
+    if (!joinable_) return;
+    pthread_join(thread_, nullptr);
+    joinable_ = false;
+}
+
+
+uint64_t LinuxThread::DeadlineOverruns() const
+{
+    return state_ ? state_->deadline_overruns.load(std::memory_order_relaxed) : 0;
+}
+
+
+uint64_t LinuxThread::StraySigxcpu()
+{
+    return stray_sigxcpu.load(std::memory_order_relaxed);
+}
+
+
+void LinuxThread::Yield()
+{
+    sched_yield();
+}
+
+
+cpu_set_t LinuxThread::CpuSet(unsigned int affinity)
+{
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    if (affinity < CPU_SETSIZE) CPU_SET(affinity, &cpuset);
+    return cpuset;
+}
+
+
+bool LinuxThread::AtExit(void (*hook)())
+{
+    for (auto& slot : exit_hooks) {
+        void (*expected)() = nullptr;
+        if (slot.compare_exchange_strong(expected, hook) || expected == hook) return true;
+    }
+    SyncLog::GetLog()->Log("LinuxThread::AtExit() : no free hook slot");
+    return false;
+}
+
+
+void LinuxThread::Reserve(std::size_t count)
+{
+    StatePool& pool = state_pool();
+    std::lock_guard<std::mutex> lck(pool.mtx);
+    while (pool.idle < count) {
+        std::size_t chunk = std::max(count - pool.idle, StatePool::kChunk);
+        auto* raw = static_cast<unsigned char*>(::operator new(chunk * sizeof(ThreadState), std::align_val_t(alignof(ThreadState))));
+        for (std::size_t idx = 0; idx < chunk; idx++) {
+            auto* node = reinterpret_cast<StatePool::Node*>(raw + idx * sizeof(ThreadState));
+            node->next = pool.free;
+            pool.free = node;
+        }
+        pool.idle += chunk;
+    }
+}
+
+
+LinuxThread::ThreadState* LinuxThread::AcquireState()
+{
+    static_assert(sizeof(ThreadState) >= sizeof(StatePool::Node), "pool entry too small");
+
+    StatePool& pool = state_pool();
+    {
+        std::lock_guard<std::mutex> lck(pool.mtx);
+        if (pool.free) {
+            StatePool::Node* node = pool.free;
+            pool.free = node->next;
+            pool.idle--;
+            return ::new (static_cast<void*>(node)) ThreadState;
+        }
+    }
+
+    Reserve(1);
+    return AcquireState();
+}
+
+
+void LinuxThread::ReleaseState(ThreadState* state)
+{
+    // one reference each for the LinuxThread object and the running thread
+    if (1 != state->refs.fetch_sub(1, std::memory_order_acq_rel)) return;
+
+    for (auto& fd : state->perf_fds) {
+        int value = fd.load(std::memory_order_relaxed);
+        if (value >= 0) close(value);
+    }
+    state->~ThreadState();
+
+    StatePool& pool = state_pool();
+    auto* node = reinterpret_cast<StatePool::Node*>(state);
+    std::lock_guard<std::mutex> lck(pool.mtx);
+    node->next = pool.free;
+    pool.free = node;
+    pool.idle++;
+}
+
+
+void LinuxThread::Start(Body body, const ThreadAttributes& attributes)
+{
+    cpus_ = attributes.Cpus();
+    state_ = AcquireState();
+    state_->body = std::move(body);
+    state_->attributes = attributes;
+    state_->name = name_;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    int rc = attributes.Apply(&attr);
+    if (rc != 0) {
+        SyncLog::GetLog()->Log("Error applying thread attributes: " + std::string(std::strerror(rc)));
+    }
+
+    rc = pthread_create(&thread_, &attr, Trampoline, state_);
+    if (EPERM == rc && attributes.ExplicitSched()) {
+        // no privilege for the requested policy, run with the creator's scheduling rather than not at all
+        SyncLog::GetLog()->Log("Failed to set Thread scheduling : " + std::string(std::strerror(rc)) + ", inheriting scheduling");
+        pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+        rc = pthread_create(&thread_, &attr, Trampoline, state_);
+    }
+    pthread_attr_destroy(&attr);
+
+    if (rc != 0) {
+        SyncLog::GetLog()->Log("Error calling pthread_create: " + std::string(std::strerror(rc)));
+        // no thread to hold the second reference
+        state_->body.Reset();
+        state_->refs.store(1, std::memory_order_relaxed);
+        return;
+    }
+
+    joinable_ = true;
+}
+
+
+void* LinuxThread::Trampoline(void* arg)
+{
+    ThreadState* state = static_cast<ThreadState*>(arg);
+    const ThreadAttributes& attributes = state->attributes;
+    state->tid.store(syscall(SYS_gettid), std::memory_order_release);
+
+    /* kernel visible name, silently truncated to 15 characters */
+    if (!state->name.empty()) pthread_setname_np(pthread_self(), state->name.c_str());
+
+    /* set deadline reservation */
+    if (attributes.HasDeadline()) {
+        deadline_overruns = &state->deadline_overruns;
+        if (0 != set_deadline(attributes.DeadlineParameters())) {
+            SyncLog::GetLog()->Log("Failed to set SCHED_DEADLINE : " + std::string(std::strerror(errno)));
+        }
+    }
+
+    /* set policy, CFS variants pthread_attr_t cannot carry */
+    if (attributes.HasThreadPolicy()) {
+        sched_param scheduler_params{};
+        if (0 != sched_setscheduler(0, attributes.ThreadPolicy(), &scheduler_params)) {
+            SyncLog::GetLog()->Log("Failed to set Thread scheduling : " + std::string(std::strerror(errno)));
+        }
+    }
+
+    /* set niceness */
+    if (attributes.HasNice() && -1 == setpriority(PRIO_PROCESS, syscall(SYS_gettid), attributes.Niceness())) {
+        SyncLog::GetLog()->Log("setpriority() failure");
+    }
+
+    /* perf counters, counting from here on */
+    if (attributes.HasPerfCounters()) {
+        for (std::size_t idx = 0; idx < std::size(perf_events); idx++) {
+            state->perf_fds[idx].store(open_perf_counter(perf_events[idx].first, perf_events[idx].second),
+                std::memory_order_release);
+        }
+    }
+
+    /* stack prefault, allocation detector */
+    if (attributes.IsRealTime()) {
+        if (attributes.PrefaultStackBytes()) RealTimeMemory::PrefaultStack(attributes.PrefaultStackBytes());
+        RealTimeMemory::MarkRealTimeThread(true);
+    }
+
+    state->body();
+
+    RealTimeMemory::MarkRealTimeThread(false);
+    deadline_overruns = nullptr;
+
+    /* captures are destroyed on the thread that ran them */
+    state->body.Reset();
+
+    /* per thread cleanup hooks */
+    for (auto& slot : exit_hooks) {
+        void (*hook)() = slot.load(std::memory_order_acquire);
+        if (!hook) break;
+        hook();
+    }
+    ReleaseState(state);
+    return nullptr;
 }
@@ -1,10 +1,80 @@
 #pragma once
 
-#include <functional>
+#include "InplaceFunction.h"
+#include "ThreadAttributes.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
 #include <string>
 #include <sys/resource.h>
+#include <sys/types.h>
 #include <thread>
 
+// per thread perf_event_open counts, -1 where the counter could not be opened
+// (no PMU under most hypervisors, kernel.perf_event_paranoid, ThreadAttributes::PerfCounters() not set)
+// - counters are scaled by time enabled / time running when the PMU had to multiplex them
+struct ThreadCounters
+{
+    int64_t cycles{-1};
+    int64_t instructions{-1};
+    int64_t cache_misses{-1};
+    int64_t context_switches{-1};
+    int64_t cpu_migrations{-1};
+    int64_t page_faults{-1};
+
+    // instructions per cycle, 0 when either is unavailable
+    double Ipc() const
+    {
+        return (cycles > 0 && instructions >= 0) ? static_cast<double>(instructions) / cycles : 0.0;
+    }
+};
+
+
+// fixed capacity thread name, the kernel keeps 15 characters (TASK_COMM_LEN), longer names are truncated
+class ThreadName
+{
+
+public:
+
+    ThreadName() = default;
+
+    ThreadName(const char* name)
+    {
+        std::strncpy(name_, name, kCapacity - 1);
+    }
+
+    ThreadName(const std::string& name) :
+        ThreadName(name.c_str())
+    {
+    }
+
+    const char* c_str() const
+    {
+        return name_;
+    }
+
+    bool empty() const
+    {
+        return '\0' == name_[0];
+    }
+
+    static constexpr std::size_t kCapacity = 16;
+
+private:
+
+    char name_[kCapacity]{};
+};
+
+
+// thread created through pthread_create so placement and scheduling are set before the thread runs
+// - construction does not allocate : callables live in an InplaceFunction (kCallableBytes of captures),
+//   the name is a ThreadName and the state shared with the running thread comes from a recycled pool
+// - a named thread also gets its name through pthread_setname_np (ps, top, perf, /proc/<tid>/comm)
+
 class LinuxThread
 {
 
@@ -16,35 +86,117 @@ public:
     // Delete the Assignment opeartor
     LinuxThread& operator=(const LinuxThread&) = delete;
 
+    static constexpr std::size_t kCallableBytes = 64;
+
+    using Function = InplaceFunction<void(), kCallableBytes>;
+    using NamedFunction = InplaceFunction<void(std::string), kCallableBytes>;
+    using SchedFunction = InplaceFunction<void(std::string, int, int), kCallableBytes>;
+
     // Parameterized Constructor
-    LinuxThread(std::function<void()> func, unsigned int affinity = -1);
+    LinuxThread(Function func, unsigned int affinity = -1);
 
     // Parameterized Constructor
-    LinuxThread(std::function<void(std::string)> func, std::string name, unsigned int affinity = -1);
+    LinuxThread(Function func, const cpu_set_t& cpus);
 
     // Parameterized Constructor
-    LinuxThread(std::function<void(std::string, int, int)> func, std::string name, int policy, int priority, unsigned int affinity = -1);
+    LinuxThread(Function func, const ThreadAttributes& attributes);
+
+    // Parameterized Constructor
+    LinuxThread(NamedFunction func, ThreadName name, unsigned int affinity = -1);
+
+    // Parameterized Constructor
+    LinuxThread(NamedFunction func, ThreadName name, const cpu_set_t& cpus);
+
+    // Parameterized Constructor
+    LinuxThread(NamedFunction func, ThreadName name, const ThreadAttributes& attributes);
+
+    // Parameterized Constructor
+    // - policy and priority go through ThreadAttributes and apply before func runs, func only gets them
+    //   passed for reference
+    LinuxThread(SchedFunction func, ThreadName name, int policy, int priority, unsigned int affinity = -1);
+
+    // Parameterized Constructor
+    LinuxThread(SchedFunction func, ThreadName name, int policy, int priority, const cpu_set_t& cpus);
  
     // Move Constructor
-    LinuxThread(LinuxThread && obj);
+    LinuxThread(LinuxThread && obj) noexcept;
  
-    // Move Assignment Operator
-    LinuxThread & operator=(LinuxThread && obj);
+    // Move Assignment Operator, joins a joinable thread first
+    LinuxThread & operator=(LinuxThread && obj) noexcept;
 
-    // Destructor
-    ~LinuxThread() = default;
+    // Destructor, joins a joinable thread
+    ~LinuxThread();
 
-    void ThreadInfo();
+    // perf counters of the thread so far (final counts once it has exited), opened at thread start when
+    // created with ThreadAttributes::PerfCounters(), the thread itself pays nothing until it is read
+    ThreadCounters ThreadInfo() const;
 
+    // kernel thread id, 0 until the thread has started
+    pid_t Tid() const;
+
+    const char* Name() const;
+
+    // false when pthread_create() failed (logged) or the thread was already joined
     bool Joinable();
 
+    // returns at once when not joinable
     void Join();
 
+    // SCHED_DEADLINE runtime overruns (SIGXCPU) seen by this thread, best effort : the signal is process
+    // directed and may be taken by another thread, see StraySigxcpu()
+    uint64_t DeadlineOverruns() const;
+
+    // SIGXCPU taken by threads that are not deadline LinuxThreads, overruns the owner missed included
+    static uint64_t StraySigxcpu();
+
+    // end the current job, a SCHED_DEADLINE thread sleeps until its next period
+    static void Yield();
+
+    // single cpu set, empty when affinity is out of range (the unsigned -1 default)
+    static cpu_set_t CpuSet(unsigned int affinity);
+
+    // grow the state pool to count idle entries so a burst of spawns does not allocate at all
+    static void Reserve(std::size_t count);
+
+    // process wide hook run by every LinuxThread on its own thread once its function returns, the place for
+    // per thread cleanup that must not wait for thread_local destructors (e.g. EpochReclaimer, HazardPointers)
+    // - up to kMaxExitHooks hooks, false when full, a hook added twice runs once
+    static bool AtExit(void (*hook)());
+
+    static constexpr std::size_t kMaxExitHooks = 8;
+
 private:
 
-    std::thread thread_;
-    std::string name_;
-    int policy_;
-    int priority_;
-    int affinity_;
+    // what the new thread runs, a user callable plus its arguments
+    using Body = InplaceFunction<void(), 2 * kCallableBytes>;
+
+    // shared by the LinuxThread object and the running thread, released by both, recycled through a pool
+    struct ThreadState
+    {
+        std::atomic<int> refs{2};
+        std::atomic<pid_t> tid{0};
+        std::atomic<uint64_t> deadline_overruns{0};
+        // cycles, instructions, cache misses, context switches, cpu migrations, page faults
+        std::atomic<int> perf_fds[6] = {-1, -1, -1, -1, -1, -1};
+
+        // start arguments, the body is destroyed on the thread once it returns
+        Body body;
+        ThreadAttributes attributes;
+        ThreadName name;
+    };
+
+    void Start(Body body, const ThreadAttributes& attributes);
+
+    static ThreadState* AcquireState();
+    static void ReleaseState(ThreadState* state);
+
+    static void* Trampoline(void* arg);
+
+    pthread_t thread_{};
+    ThreadState* state_{nullptr};
+    bool joinable_{false};
+    ThreadName name_;
+    int policy_{SCHED_OTHER};
+    int priority_{0};
+    cpu_set_t cpus_{};
 };
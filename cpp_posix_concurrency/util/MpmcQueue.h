@@ -0,0 +1,286 @@
+#pragma once
+
+#include "CacheLine.h"
+#include "Futex.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+
+// bounded multi producer / multi consumer queue (Vyukov's sequence numbered ring)
+// - capacity is rounded up to a power of two, T must be default constructible and move assignable
+// - each slot carries a sequence : == position when free for the producer of that position,
+//   == position + 1 once filled for its consumer, so producers and consumers only contend on head / tail
+// - Try* never block, Push / Pop spin briefly then park on a futex until the other side makes progress
+// - batch calls claim a run of positions with one CAS, a batch may wait for a preempted thread
+//   still moving an item in or out of a slot of the run
+// - Close() once the producers are done : it wakes every parked thread, pushes then fail and pops
+//   drain what is left
+
+template <typename T>
+class MpmcQueue
+{
+
+public:
+
+    explicit MpmcQueue(std::size_t capacity) :
+        mask_(RoundUpPow2(capacity) - 1),
+        slots_(new Slot[mask_ + 1])
+    {
+        for (std::size_t pos = 0; pos <= mask_; pos++) slots_[pos].seq.store(pos, std::memory_order_relaxed);
+    }
+
+    // Delete the copy constructor
+    MpmcQueue(const MpmcQueue&) = delete;
+
+    // Delete the Assignment opeartor
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    // item is only moved from when it goes in
+    template <typename U>
+    bool TryPush(U&& item)
+    {
+        if (closed_.load(std::memory_order_relaxed)) return false;
+
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & mask_];
+            std::size_t seq = slot.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (0 == diff) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = std::forward<U>(item);
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    Wake(not_empty_);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // slot not consumed yet a lap ago : full
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TryPop(T& item)
+    {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & mask_];
+            std::size_t seq = slot.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (0 == diff) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    item = std::move(slot.value);
+                    slot.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    Wake(not_full_);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // slot not filled yet : empty
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // blocks while full, false once closed
+    bool Push(T item)
+    {
+        return Block(not_full_, [&]() {
+            if (closed_.load(std::memory_order_relaxed)) return Result::FAILED;
+            return TryPush(std::move(item)) ? Result::DONE : Result::RETRY;
+        });
+    }
+
+    // blocks while empty, false once closed and drained
+    bool Pop(T& item)
+    {
+        return Block(not_empty_, [&]() {
+            if (TryPop(item)) return Result::DONE;
+            return closed_.load(std::memory_order_acquire) && 0 == Size() ? Result::FAILED : Result::RETRY;
+        });
+    }
+
+    // moves up to count items in, returns how many went in (a prefix of items)
+    std::size_t TryPushBatch(T* items, std::size_t count)
+    {
+        if (0 == count || closed_.load(std::memory_order_relaxed)) return 0;
+
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        std::size_t claimed;
+        do {
+            // free positions as far as the consumers have claimed, they release their slots shortly
+            std::size_t free = mask_ + 1 - (pos - tail_.load(std::memory_order_acquire));
+            if (static_cast<intptr_t>(free) <= 0) return 0;
+            claimed = count < free ? count : free;
+        } while (!head_.compare_exchange_weak(pos, pos + claimed, std::memory_order_relaxed));
+
+        for (std::size_t idx = 0; idx < claimed; idx++) {
+            Slot& slot = slots_[(pos + idx) & mask_];
+            while (slot.seq.load(std::memory_order_acquire) != pos + idx) CpuRelax();
+            slot.value = std::move(items[idx]);
+            slot.seq.store(pos + idx + 1, std::memory_order_release);
+        }
+        Wake(not_empty_);
+        return claimed;
+    }
+
+    // moves up to count items out, returns how many came out
+    std::size_t TryPopBatch(T* items, std::size_t count)
+    {
+        if (0 == count) return 0;
+
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        std::size_t claimed;
+        do {
+            // positions claimed by producers, their items land shortly
+            std::size_t ready = head_.load(std::memory_order_acquire) - pos;
+            if (static_cast<intptr_t>(ready) <= 0) return 0;
+            claimed = count < ready ? count : ready;
+        } while (!tail_.compare_exchange_weak(pos, pos + claimed, std::memory_order_relaxed));
+
+        for (std::size_t idx = 0; idx < claimed; idx++) {
+            Slot& slot = slots_[(pos + idx) & mask_];
+            while (slot.seq.load(std::memory_order_acquire) != pos + idx + 1) CpuRelax();
+            items[idx] = std::move(slot.value);
+            slot.seq.store(pos + idx + mask_ + 1, std::memory_order_release);
+        }
+        Wake(not_full_);
+        return claimed;
+    }
+
+    // blocks until all count items are in, returns fewer only once closed
+    std::size_t PushBatch(T* items, std::size_t count)
+    {
+        std::size_t pushed = 0;
+        Block(not_full_, [&]() {
+            if (closed_.load(std::memory_order_relaxed)) return Result::FAILED;
+            pushed += TryPushBatch(items + pushed, count - pushed);
+            return pushed == count ? Result::DONE : Result::RETRY;
+        });
+        return pushed;
+    }
+
+    // blocks until at least one item is out, 0 once closed and drained
+    std::size_t PopBatch(T* items, std::size_t count)
+    {
+        std::size_t popped = 0;
+        Block(not_empty_, [&]() {
+            popped = TryPopBatch(items, count);
+            if (popped) return Result::DONE;
+            return closed_.load(std::memory_order_acquire) && 0 == Size() ? Result::FAILED : Result::RETRY;
+        });
+        return popped;
+    }
+
+    // wake every blocked thread, later pushes fail, pops drain the remaining items
+    void Close()
+    {
+        closed_.store(true, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (std::atomic<uint32_t>* word : {&not_empty_, &not_full_}) {
+            word->fetch_add(2, std::memory_order_release);
+            FutexWake(word, INT32_MAX);
+        }
+    }
+
+    bool Closed() const
+    {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    // approximate depth, safe from any thread
+    std::size_t Size() const
+    {
+        std::size_t tail = tail_.load(std::memory_order_acquire);
+        std::size_t head = head_.load(std::memory_order_acquire);
+        return head > tail ? head - tail : 0;
+    }
+
+    std::size_t Capacity() const
+    {
+        return mask_ + 1;
+    }
+
+private:
+
+    static constexpr int kSpins = 128;
+
+    enum class Result {
+        DONE,
+        RETRY,
+        FAILED
+    };
+
+    struct Slot
+    {
+        std::atomic<std::size_t> seq;
+        T value{};
+    };
+
+    static std::size_t RoundUpPow2(std::size_t value)
+    {
+        std::size_t pow2 = 1;
+        while (pow2 < value) pow2 <<= 1;
+        return pow2;
+    }
+
+    // retry attempt() until it is done or failed, spinning first, then parked on word
+    // - word is an event count : bit 0 says someone may sleep on it, the rest is bumped by a waking update
+    // - a waiter sets the bit before its last attempt and the other side checks the bit after its update
+    //   (both behind a full fence), so either the attempt sees the update or the update wakes it
+    // - the waker clears the bit and wakes everyone, later updates skip the syscall until someone parks
+    //   again (one wake per sleep rather than per item, a woken thread that loses the race parks again)
+    template <typename Attempt>
+    bool Block(std::atomic<uint32_t>& word, Attempt attempt)
+    {
+        for (int spin = 0; spin < kSpins; spin++) {
+            Result result = attempt();
+            if (Result::RETRY != result) return Result::DONE == result;
+            CpuRelax();
+        }
+
+        while (true) {
+            uint32_t epoch = word.load(std::memory_order_acquire);
+            if (0 == (epoch & 1)) {
+                if (!word.compare_exchange_weak(epoch, epoch | 1, std::memory_order_relaxed)) continue;
+                epoch |= 1;
+            }
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            Result result = attempt();
+            if (Result::RETRY != result) return Result::DONE == result;
+
+            FutexWait(&word, epoch);
+        }
+    }
+
+    static void Wake(std::atomic<uint32_t>& word)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32_t epoch = word.load(std::memory_order_relaxed);
+        if (0 == (epoch & 1)) return;
+        // a failed exchange means another update already woke the sleepers
+        if (word.compare_exchange_strong(epoch, (epoch + 2) & ~1u, std::memory_order_release)) FutexWake(&word, INT32_MAX);
+    }
+
+    // producer side
+    alignas(kCacheLineSize) std::atomic<std::size_t> head_{0};
+
+    // consumer side
+    alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0};
+
+    // futex event counts, see Block()
+    alignas(kCacheLineSize) std::atomic<uint32_t> not_empty_{0};
+    alignas(kCacheLineSize) std::atomic<uint32_t> not_full_{0};
+    std::atomic<bool> closed_{false};
+
+    // read only after construction
+    alignas(kCacheLineSize) const std::size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+};
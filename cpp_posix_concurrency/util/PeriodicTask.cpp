@@ -0,0 +1,142 @@
+#include "PeriodicTask.h"
+
+#include "SyncLog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <initializer_list>
+#include <string>
+#include <time.h>
+
+namespace {
+
+int64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void sleep_until(int64_t deadline_ns)
+{
+    timespec ts{static_cast<time_t>(deadline_ns / 1000000000), static_cast<long>(deadline_ns % 1000000000)};
+    while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr)) {}
+}
+
+}
+
+
+PeriodicTask::PeriodicTask(ThreadName name, std::chrono::nanoseconds period, std::function<void()> cycle,
+    const ThreadAttributes& attributes, OverrunPolicy policy, std::chrono::nanoseconds deadline) :
+    name_(name),
+    period_ns_(std::max<int64_t>(period.count(), 1)),
+    deadline_ns_(deadline.count() > 0 ? deadline.count() : period_ns_),
+    policy_(policy),
+    cycle_(std::move(cycle))
+{
+    thread_.reset(new LinuxThread([this](std::string) { Loop(); }, name_, attributes));
+}
+
+
+PeriodicTask::~PeriodicTask()
+{
+    Stop();
+}
+
+
+void PeriodicTask::Stop()
+{
+    stopping_.store(true, std::memory_order_release);
+    if (thread_ && thread_->Joinable()) thread_->Join();
+}
+
+
+PeriodicTask::PeriodicStats PeriodicTask::Stats() const
+{
+    PeriodicStats stats;
+    stats.cycles = cycles_.load(std::memory_order_relaxed);
+    stats.overruns = overruns_.load(std::memory_order_relaxed);
+    stats.skipped = skipped_.load(std::memory_order_relaxed);
+    stats.exec_last_ns = exec_last_ns_.load(std::memory_order_relaxed);
+    stats.exec_max_ns = exec_max_ns_.load(std::memory_order_relaxed);
+    stats.jitter_last_ns = jitter_last_ns_.load(std::memory_order_relaxed);
+    stats.jitter_max_ns = jitter_max_ns_.load(std::memory_order_relaxed);
+    double cycles = static_cast<double>(std::max<uint64_t>(stats.cycles, 1));
+    stats.exec_avg_ns = exec_sum_ns_.load(std::memory_order_relaxed) / cycles;
+    stats.jitter_avg_ns = jitter_sum_ns_.load(std::memory_order_relaxed) / cycles;
+    return stats;
+}
+
+
+void PeriodicTask::ResetStats()
+{
+    // the task thread clears them before its next record, it stays the only writer
+    reset_.store(true, std::memory_order_release);
+}
+
+
+void PeriodicTask::Report() const
+{
+    PeriodicStats stats = Stats();
+    SyncLog::GetLog()->Log(std::string(name_.c_str())
+        + " : period " + std::to_string(period_ns_ / 1000) + " us"
+        + ", cycles " + std::to_string(stats.cycles)
+        + ", overruns " + std::to_string(stats.overruns)
+        + ", skipped " + std::to_string(stats.skipped)
+        + ", exec avg " + std::to_string(static_cast<int64_t>(stats.exec_avg_ns) / 1000)
+        + " max " + std::to_string(stats.exec_max_ns / 1000) + " us"
+        + ", jitter avg " + std::to_string(static_cast<int64_t>(stats.jitter_avg_ns) / 1000)
+        + " max " + std::to_string(stats.jitter_max_ns / 1000) + " us");
+}
+
+
+std::chrono::nanoseconds PeriodicTask::Period() const
+{
+    return std::chrono::nanoseconds(period_ns_);
+}
+
+
+void PeriodicTask::Loop()
+{
+    int64_t release = now_ns();
+
+    while (!stopping_.load(std::memory_order_acquire)) {
+        int64_t start = now_ns();
+        cycle_();
+        int64_t end = now_ns();
+
+        Record(start - release, end - start);
+        if (end > release + deadline_ns_) overruns_.store(overruns_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        release += period_ns_;
+        if (end > release && OverrunPolicy::SKIP == policy_) {
+            // releases already in the past are dropped, the next cycle starts on the grid again
+            int64_t missed = (end - release) / period_ns_ + 1;
+            release += missed * period_ns_;
+            skipped_.store(skipped_.load(std::memory_order_relaxed) + missed, std::memory_order_relaxed);
+        }
+        sleep_until(release);
+    }
+}
+
+
+void PeriodicTask::Record(int64_t jitter_ns, int64_t exec_ns)
+{
+    if (reset_.exchange(false, std::memory_order_acquire)) {
+        for (auto* counter : {&cycles_, &overruns_, &skipped_}) counter->store(0, std::memory_order_relaxed);
+        for (auto* value : {&exec_last_ns_, &exec_max_ns_, &exec_sum_ns_, &jitter_last_ns_, &jitter_max_ns_, &jitter_sum_ns_}) {
+            value->store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // single writer, plain load + store instead of read-modify-write
+    exec_last_ns_.store(exec_ns, std::memory_order_relaxed);
+    exec_sum_ns_.store(exec_sum_ns_.load(std::memory_order_relaxed) + exec_ns, std::memory_order_relaxed);
+    if (exec_ns > exec_max_ns_.load(std::memory_order_relaxed)) exec_max_ns_.store(exec_ns, std::memory_order_relaxed);
+
+    jitter_last_ns_.store(jitter_ns, std::memory_order_relaxed);
+    jitter_sum_ns_.store(jitter_sum_ns_.load(std::memory_order_relaxed) + jitter_ns, std::memory_order_relaxed);
+    if (jitter_ns > jitter_max_ns_.load(std::memory_order_relaxed)) jitter_max_ns_.store(jitter_ns, std::memory_order_relaxed);
+
+    cycles_.store(cycles_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "LinuxThread.h"
+#include "ThreadAttributes.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+// fixed rate cycle on its own LinuxThread, the core of a control loop
+// - releases sit on an absolute grid (origin + n * period) reached with
+//   clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME), so a slow cycle never shifts the later ones
+// - per cycle : start jitter (actual start - release) and execution time
+// - overrun : a cycle that ends after release + deadline (deadline defaults to the period)
+// - a cycle running past later releases either skips them (SKIP, counted as skipped cycles) or runs
+//   them back to back to catch up (CATCH_UP)
+// - Stats() is safe from any thread while the task runs, fields are read one by one
+// - starts on construction, Stop() / destruction take effect at the next release
+//
+// PeriodicTask loop("control", std::chrono::milliseconds(1), [] { Control(); },
+//     ThreadAttributes().Policy(SCHED_FIFO).Priority(80).RealTime(64 * 1024));
+
+class PeriodicTask
+{
+
+public:
+
+    enum class OverrunPolicy {
+        SKIP,
+        CATCH_UP
+    };
+
+    struct PeriodicStats
+    {
+        uint64_t cycles;
+        uint64_t overruns;
+        uint64_t skipped;
+        int64_t exec_last_ns;
+        int64_t exec_max_ns;
+        double exec_avg_ns;
+        int64_t jitter_last_ns;
+        int64_t jitter_max_ns;
+        double jitter_avg_ns;
+    };
+
+    PeriodicTask(ThreadName name, std::chrono::nanoseconds period, std::function<void()> cycle,
+        const ThreadAttributes& attributes = ThreadAttributes(), OverrunPolicy policy = OverrunPolicy::SKIP,
+        std::chrono::nanoseconds deadline = std::chrono::nanoseconds(0));
+
+    // Delete the copy constructor
+    PeriodicTask(const PeriodicTask&) = delete;
+
+    // Delete the Assignment opeartor
+    PeriodicTask& operator=(const PeriodicTask&) = delete;
+
+    // stops and joins
+    ~PeriodicTask();
+
+    // no cycle starts after this returns
+    void Stop();
+
+    PeriodicStats Stats() const;
+
+    void ResetStats();
+
+    // one SyncLog line
+    void Report() const;
+
+    std::chrono::nanoseconds Period() const;
+
+private:
+
+    void Loop();
+    void Record(int64_t jitter_ns, int64_t exec_ns);
+
+    const ThreadName name_;
+    const int64_t period_ns_;
+    const int64_t deadline_ns_;
+    const OverrunPolicy policy_;
+    std::function<void()> cycle_;
+
+    // written by the task thread only
+    std::atomic<uint64_t> cycles_{0};
+    std::atomic<uint64_t> overruns_{0};
+    std::atomic<uint64_t> skipped_{0};
+    std::atomic<int64_t> exec_last_ns_{0};
+    std::atomic<int64_t> exec_max_ns_{0};
+    std::atomic<int64_t> exec_sum_ns_{0};
+    std::atomic<int64_t> jitter_last_ns_{0};
+    std::atomic<int64_t> jitter_max_ns_{0};
+    std::atomic<int64_t> jitter_sum_ns_{0};
+    std::atomic<bool> reset_{false};
+
+    std::atomic<bool> stopping_{false};
+    std::unique_ptr<LinuxThread> thread_;
+};
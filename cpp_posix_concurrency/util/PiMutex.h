@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cassert>
+#include <cerrno>
+#include <pthread.h>
+#include <system_error>
+
+// pthread mutex with a selectable priority protocol, for locks shared between realtime and background threads
+// (e.g. a log lock : a background holder preempted by a medium priority thread must not stall a realtime logger)
+// - INHERIT (PTHREAD_PRIO_INHERIT) : a holder blocking a higher priority thread runs at that thread's priority
+//   until it unlocks, so a medium priority thread can no longer stretch the wait (priority inversion)
+// - PROTECT (PTHREAD_PRIO_PROTECT) : the holder runs at ceiling for as long as it holds the lock,
+//   ceiling must be at least the priority of every thread that takes it, raising a SCHED_OTHER
+//   holder to the ceiling needs CAP_SYS_NICE / RLIMIT_RTPRIO
+// - NONE : a plain pthread mutex, the behaviour of std::mutex
+// - meets the std Lockable requirements and throws std::system_error like std::mutex, unlock() asserts
+//   instead (EPERM when the caller does not own the lock, PROTECT errors restoring the priority)
+
+class PiMutex
+{
+
+public:
+
+    enum class Protocol {
+        NONE,
+        INHERIT,
+        PROTECT
+    };
+
+    explicit PiMutex(Protocol protocol = Protocol::INHERIT, int ceiling = 0)
+    {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+
+        int ret{0};
+        if (Protocol::INHERIT == protocol) {
+            ret = pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+        } else if (Protocol::PROTECT == protocol) {
+            ret = pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_PROTECT);
+            if (0 == ret) ret = pthread_mutexattr_setprioceiling(&attr, ceiling);
+        }
+        if (0 == ret) ret = pthread_mutex_init(&mtx_, &attr);
+
+        pthread_mutexattr_destroy(&attr);
+        if (0 != ret) throw std::system_error(ret, std::generic_category(), "PiMutex init");
+    }
+
+    // Delete the copy constructor
+    PiMutex(const PiMutex&) = delete;
+
+    // Delete the Assignment opeartor
+    PiMutex& operator=(const PiMutex&) = delete;
+
+    ~PiMutex()
+    {
+        pthread_mutex_destroy(&mtx_);
+    }
+
+    // EINVAL for PROTECT when the caller's priority is above the ceiling
+    void lock()
+    {
+        int ret = pthread_mutex_lock(&mtx_);
+        if (0 != ret) throw std::system_error(ret, std::generic_category(), "PiMutex lock");
+    }
+
+    bool try_lock()
+    {
+        int ret = pthread_mutex_trylock(&mtx_);
+        if (EBUSY == ret) return false;
+        if (0 != ret) throw std::system_error(ret, std::generic_category(), "PiMutex try_lock");
+        return true;
+    }
+
+    // unlock runs in destructors (std::lock_guard), it must not throw
+    void unlock()
+    {
+        int ret = pthread_mutex_unlock(&mtx_);
+        assert(0 == ret && "PiMutex unlock");
+        (void)ret;
+    }
+
+    pthread_mutex_t* native_handle()
+    {
+        return &mtx_;
+    }
+
+private:
+
+    pthread_mutex_t mtx_;
+};
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "CacheLine.h"
+#include "LinuxThread.h"
+#include "SpscRing.h"
+#include "SyncLog.h"
+#include "ThreadAttributes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// staged pipeline, one LinuxThread per stage connected by bounded SPSC rings
+// - stage func runs in place on each item, the item then moves to the next stage's ring, the last stage is the sink
+// - stages take up to max_batch items per pass and publish them downstream in one store
+// - a full downstream ring stalls the stage (backpressure), an empty input makes it yield, then sleep
+// - Stats() gives per stage throughput, stalls and ring depth : a stage with a full input ring and an
+//   upstream that stalls is the bottleneck, give it a core of its own or split it
+// - one producer thread calls Push(), then Close() once the stream ends
+
+template <typename T>
+class Pipeline
+{
+
+public:
+
+    struct StageStats
+    {
+        std::string name;
+        uint64_t processed;
+        uint64_t batches;
+        uint64_t stalls;
+        std::size_t depth;
+        std::size_t capacity;
+        double items_per_sec;
+    };
+
+    // Delete the copy constructor
+    Pipeline(const Pipeline&) = delete;
+
+    // Delete the Assignment opeartor
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    explicit Pipeline(std::size_t ring_capacity = 1024, std::size_t max_batch = 64) :
+        ring_capacity_(ring_capacity),
+        max_batch_(max_batch)
+    {
+    }
+
+    // closes the stream and joins the stages
+    ~Pipeline()
+    {
+        Close();
+        Wait();
+    }
+
+    // stages run in the order added, add them all before Start()
+    void AddStage(std::string name, std::function<void(T&)> func, const ThreadAttributes& attributes = ThreadAttributes())
+    {
+        auto stage = std::make_unique<Stage>(ring_capacity_);
+        stage->name = std::move(name);
+        stage->func = std::move(func);
+        stage->attributes = attributes;
+        stages_.push_back(std::move(stage));
+    }
+
+    void Start()
+    {
+        start_ = std::chrono::steady_clock::now();
+        for (std::size_t idx = 0; idx < stages_.size(); idx++) {
+            stages_[idx]->thread = std::make_unique<LinuxThread>([this, idx]() { StageLoop(idx); }, stages_[idx]->attributes);
+        }
+    }
+
+    // producer : false when the first stage is full
+    bool TryPush(T item)
+    {
+        return stages_.front()->input.TryPush(std::move(item));
+    }
+
+    // producer : yields while the first stage is full
+    void Push(T item)
+    {
+        SpscRing<T>& input = stages_.front()->input;
+        T* slot;
+        while (!(slot = input.Claim())) std::this_thread::yield();
+        *slot = std::move(item);
+        input.Publish();
+    }
+
+    // producer : end of stream, stages drain what is queued and exit
+    void Close()
+    {
+        closed_.store(true, std::memory_order_release);
+    }
+
+    // join the stages, call Close() first
+    void Wait()
+    {
+        for (auto& stage : stages_) {
+            if (stage->thread && stage->thread->Joinable()) stage->thread->Join();
+        }
+    }
+
+    std::vector<StageStats> Stats() const
+    {
+        std::vector<StageStats> stats;
+        auto now = std::chrono::steady_clock::now();
+
+        for (auto& stage : stages_) {
+            // a finished stage is rated over its own run time
+            int64_t end_ns = stage->end_ns.load(std::memory_order_acquire);
+            double seconds = end_ns ? end_ns * 1e-9 : std::chrono::duration<double>(now - start_).count();
+            uint64_t processed = stage->processed.load(std::memory_order_relaxed);
+
+            stats.push_back({stage->name, processed, stage->batches.load(std::memory_order_relaxed),
+                stage->stalls.load(std::memory_order_relaxed), stage->input.Size(), stage->input.Capacity(),
+                seconds > 0 ? processed / seconds : 0.0});
+        }
+        return stats;
+    }
+
+    void Report() const
+    {
+        for (auto& stage : Stats()) {
+            SyncLog::GetLog()->Log("stage " + stage.name
+                + " : processed " + std::to_string(stage.processed)
+                + ", items/s " + std::to_string(static_cast<uint64_t>(stage.items_per_sec))
+                + ", avg batch " + std::to_string(stage.batches ? stage.processed / stage.batches : 0)
+                + ", stalls " + std::to_string(stage.stalls)
+                + ", depth " + std::to_string(stage.depth) + "/" + std::to_string(stage.capacity));
+        }
+    }
+
+private:
+
+    struct Stage
+    {
+        explicit Stage(std::size_t capacity) :
+            input(capacity)
+        {
+        }
+
+        std::string name;
+        std::function<void(T&)> func;
+        ThreadAttributes attributes;
+        SpscRing<T> input;
+
+        // written by the stage thread only, read by Stats()
+        alignas(kCacheLineSize) std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> batches{0};
+        std::atomic<uint64_t> stalls{0};
+        std::atomic<int64_t> end_ns{0};
+        std::atomic<bool> done{false};
+
+        alignas(kCacheLineSize) std::unique_ptr<LinuxThread> thread;
+    };
+
+    void StageLoop(std::size_t idx)
+    {
+        Stage& stage = *stages_[idx];
+        SpscRing<T>& input = stage.input;
+        SpscRing<T>* output = (idx + 1 < stages_.size()) ? &stages_[idx + 1]->input : nullptr;
+        const std::atomic<bool>& upstream_done = (0 == idx) ? closed_ : stages_[idx - 1]->done;
+        unsigned int idle{0};
+
+        while (true) {
+
+            std::size_t count = std::min(input.Available(), max_batch_);
+
+            if (0 == count) {
+                // recheck after the flag, the last items are published before done is set
+                if (upstream_done.load(std::memory_order_acquire) && 0 == input.Available()) break;
+                if (idle++ < kIdleYields) std::this_thread::yield();
+                else std::this_thread::sleep_for(kIdleSleep);
+                continue;
+            }
+            idle = 0;
+
+            for (std::size_t i = 0; i < count; i++) stage.func(input.Peek(i));
+
+            if (output) Forward(stage, input, *output, count);
+
+            input.Consume(count);
+            stage.processed.store(stage.processed.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+            stage.batches.store(stage.batches.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        stage.end_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count(),
+            std::memory_order_release);
+        stage.done.store(true, std::memory_order_release);
+    }
+
+    // move count items downstream, publishing as many as fit at a time
+    void Forward(Stage& stage, SpscRing<T>& input, SpscRing<T>& output, std::size_t count)
+    {
+        std::size_t sent{0};
+        std::size_t claimed{0};
+
+        while (sent < count) {
+            T* slot = output.Claim(claimed);
+            if (slot) {
+                *slot = std::move(input.Peek(sent + claimed));
+                if (sent + ++claimed < count) continue;
+            }
+            if (claimed) {
+                output.Publish(claimed);
+                sent += claimed;
+                claimed = 0;
+            } else {
+                stage.stalls.store(stage.stalls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    static constexpr unsigned int kIdleYields = 64;
+    static constexpr std::chrono::microseconds kIdleSleep{50};
+
+    const std::size_t ring_capacity_;
+    const std::size_t max_batch_;
+    std::vector<std::unique_ptr<Stage>> stages_;
+    std::atomic<bool> closed_{false};
+    std::chrono::steady_clock::time_point start_;
+};
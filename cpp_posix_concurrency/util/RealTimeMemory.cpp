@@ -0,0 +1,107 @@
+#include "RealTimeMemory.h"
+
+#include <alloca.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+// plain thread_local bool : no tls constructor, safe to read from inside malloc
+thread_local bool realtime_thread{false};
+
+std::atomic<RealTimeMemory::AllocationMode> allocation_mode{RealTimeMemory::AllocationMode::OFF};
+std::atomic<uint64_t> realtime_allocations{0};
+
+}
+
+
+bool RealTimeMemory::LockAll()
+{
+    // freed memory stays in the heap, large blocks come from the heap rather than fresh mmap() pages
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    return 0 == mlockall(MCL_CURRENT | MCL_FUTURE);
+}
+
+
+void RealTimeMemory::PrefaultStack(std::size_t bytes)
+{
+    // nothing to touch, stack[bytes - 1] would be far out of the frame
+    if (0 == bytes) return;
+
+    // volatile and used below so the compiler keeps the touches
+    volatile unsigned char* stack = static_cast<volatile unsigned char*>(alloca(bytes));
+    long page_size = sysconf(_SC_PAGESIZE);
+    for (std::size_t offset = 0; offset < bytes; offset += page_size) stack[offset] = 0;
+    stack[bytes - 1] = 0;
+}
+
+
+void RealTimeMemory::PrefaultHeap(std::size_t bytes)
+{
+    unsigned char* heap = static_cast<unsigned char*>(std::malloc(bytes));
+    if (!heap) return;
+    long page_size = sysconf(_SC_PAGESIZE);
+    for (std::size_t offset = 0; offset < bytes; offset += page_size) heap[offset] = 0;
+    // with trimming disabled by LockAll() the pages stay mapped for later allocations
+    std::free(heap);
+}
+
+
+void RealTimeMemory::MarkRealTimeThread(bool realtime)
+{
+    realtime_thread = realtime;
+}
+
+
+bool RealTimeMemory::IsRealTimeThread()
+{
+    return realtime_thread;
+}
+
+
+void RealTimeMemory::SetAllocationMode(AllocationMode mode)
+{
+    allocation_mode.store(mode, std::memory_order_relaxed);
+}
+
+
+RealTimeMemory::AllocationMode RealTimeMemory::GetAllocationMode()
+{
+    return allocation_mode.load(std::memory_order_relaxed);
+}
+
+
+uint64_t RealTimeMemory::RealTimeAllocations()
+{
+    return realtime_allocations.load(std::memory_order_relaxed);
+}
+
+
+void RealTimeMemory::OnAllocation(const char* function)
+{
+    if (!realtime_thread) return;
+
+    switch (allocation_mode.load(std::memory_order_relaxed)) {
+        case AllocationMode::COUNT:
+            realtime_allocations.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case AllocationMode::ABORT: {
+            // no stdio here, we are inside the allocator
+            static const char prefix[] = "RealTimeMemory: allocator call from real-time thread : ";
+            ssize_t rc = write(STDERR_FILENO, prefix, sizeof(prefix) - 1);
+            rc = write(STDERR_FILENO, function, std::strlen(function));
+            rc = write(STDERR_FILENO, "\n", 1);
+            (void)rc;
+            std::abort();
+        }
+        case AllocationMode::OFF:
+        default:
+            break;
+    }
+}
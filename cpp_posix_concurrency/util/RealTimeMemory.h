@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// real-time memory hygiene
+// - LockAll() : mlockall(MCL_CURRENT | MCL_FUTURE) and keep freed heap resident
+// - PrefaultStack() / PrefaultHeap() : take the page faults up front instead of inside the control loop
+// - allocation detector : threads marked real-time (ThreadAttributes::RealTime()) count or abort on malloc / free.
+//   Detection needs the interposed allocator, link RtAllocGuard.cpp into the binary to enable it
+
+class RealTimeMemory
+{
+
+public:
+
+    enum class AllocationMode {
+        OFF,
+        COUNT,
+        ABORT
+    };
+
+    // false when mlockall() fails (needs CAP_IPC_LOCK or a large enough $ ulimit -l)
+    static bool LockAll();
+
+    // touch bytes of stack below the calling frame, keep bytes well under the thread's stack size
+    static void PrefaultStack(std::size_t bytes);
+
+    // fault in bytes of heap and hand it back to malloc without returning it to the kernel
+    static void PrefaultHeap(std::size_t bytes);
+
+    // real-time flag of the calling thread, checked by the interposed allocator
+    static void MarkRealTimeThread(bool realtime);
+    static bool IsRealTimeThread();
+
+    static void SetAllocationMode(AllocationMode mode);
+    static AllocationMode GetAllocationMode();
+
+    // malloc / free family calls made from real-time threads while the mode is COUNT
+    static uint64_t RealTimeAllocations();
+
+    // called by the interposed allocator on every allocation call
+    static void OnAllocation(const char* function);
+};
@@ -0,0 +1,64 @@
+// interposed malloc family feeding RealTimeMemory's allocation detector
+// - link this file into a binary to enable detection, it forwards to glibc's __libc_* entry points
+// - operator new / delete reach these through libstdc++
+
+#include "RealTimeMemory.h"
+
+#include <cstddef>
+#include <errno.h>
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void __libc_free(void* ptr);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size)
+{
+    RealTimeMemory::OnAllocation("malloc");
+    return __libc_malloc(size);
+}
+
+void free(void* ptr)
+{
+    if (ptr) RealTimeMemory::OnAllocation("free");
+    __libc_free(ptr);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    RealTimeMemory::OnAllocation("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    RealTimeMemory::OnAllocation("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    RealTimeMemory::OnAllocation("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    RealTimeMemory::OnAllocation("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    RealTimeMemory::OnAllocation("posix_memalign");
+    if (0 == alignment || (alignment & (alignment - 1)) || alignment % sizeof(void*)) return EINVAL;
+    void* block = __libc_memalign(alignment, size);
+    if (!block) return ENOMEM;
+    *ptr = block;
+    return 0;
+}
+
+}
@@ -0,0 +1,165 @@
+#include "SchedSampler.h"
+
+#include "SyncLog.h"
+
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+namespace {
+
+// "key   :   value" lines of /proc/<tid>/sched, "key:\tvalue" lines of /proc/<tid>/status
+bool read_key_values(const std::string& path, std::map<std::string, int64_t>& values)
+{
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::size_t colon = line.find(':');
+        if (std::string::npos == colon) continue;
+        std::string key = line.substr(0, colon);
+        key.erase(key.find_last_not_of(" \t") + 1);
+        std::istringstream value(line.substr(colon + 1));
+        int64_t number;
+        if (value >> number) values[key] = number;
+    }
+    return true;
+}
+
+}
+
+
+bool SchedSampler::ReadThread(pid_t tid, ThreadSched& sched)
+{
+    std::string task_dir = "/proc/self/task/" + std::to_string(tid);
+
+    std::ifstream schedstat(task_dir + "/schedstat");
+    if (!(schedstat >> sched.run_ns >> sched.wait_ns >> sched.timeslices)) return false;
+
+    sched.tid = tid;
+    std::ifstream comm(task_dir + "/comm");
+    std::getline(comm, sched.name);
+
+    std::map<std::string, int64_t> values;
+    if (read_key_values(task_dir + "/sched", values) && values.count("nr_voluntary_switches")) {
+        sched.voluntary_switches = values["nr_voluntary_switches"];
+        sched.involuntary_switches = values["nr_involuntary_switches"];
+        sched.migrations = values.count("se.nr_migrations") ? values["se.nr_migrations"] : -1;
+    } else if (read_key_values(task_dir + "/status", values)) {
+        sched.voluntary_switches = values.count("voluntary_ctxt_switches") ? values["voluntary_ctxt_switches"] : -1;
+        sched.involuntary_switches = values.count("nonvoluntary_ctxt_switches") ? values["nonvoluntary_ctxt_switches"] : -1;
+        sched.migrations = -1;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+
+std::vector<SchedSampler::ThreadSched> SchedSampler::ReadAll()
+{
+    std::vector<ThreadSched> threads;
+
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) return threads;
+    while (dirent* entry = readdir(dir)) {
+        if ('.' == entry->d_name[0]) continue;
+        ThreadSched sched;
+        if (ReadThread(std::stoi(entry->d_name), sched)) threads.push_back(sched);
+    }
+    closedir(dir);
+
+    return threads;
+}
+
+
+SchedSampler::SchedSampler(std::chrono::milliseconds interval, bool report) :
+    interval_(interval),
+    report_(report)
+{
+    thread_ = std::make_unique<LinuxThread>([this]() {
+        self_ = syscall(SYS_gettid);
+        for (const ThreadSched& sched : ReadAll()) previous_[sched.tid] = sched;
+
+        std::unique_lock<std::mutex> lck (mtx_);
+        while (!cv_.wait_for(lck, interval_, [this]() { return stopping_; })) {
+            lck.unlock();
+            Sample();
+            if (report_) Report();
+            lck.lock();
+        }
+    });
+}
+
+
+SchedSampler::~SchedSampler()
+{
+    {
+        std::lock_guard<std::mutex> lck (mtx_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    thread_->Join();
+}
+
+
+void SchedSampler::Sample()
+{
+    std::vector<ThreadSched> interval;
+    std::map<pid_t, ThreadSched> current_threads;
+
+    // threads started during the interval only get a baseline, exited ones drop out
+    for (const ThreadSched& current : ReadAll()) {
+        current_threads[current.tid] = current;
+        auto found = previous_.find(current.tid);
+        if (found == previous_.end() || self_ == current.tid) continue;
+
+        const ThreadSched& before = found->second;
+        ThreadSched delta = current;
+        delta.run_ns = current.run_ns - before.run_ns;
+        delta.wait_ns = current.wait_ns - before.wait_ns;
+        delta.timeslices = current.timeslices - before.timeslices;
+        delta.voluntary_switches = current.voluntary_switches - before.voluntary_switches;
+        delta.involuntary_switches = current.involuntary_switches - before.involuntary_switches;
+        delta.migrations = (current.migrations < 0) ? -1 : current.migrations - before.migrations;
+        interval.push_back(delta);
+    }
+    previous_ = std::move(current_threads);
+
+    std::lock_guard<std::mutex> lck (mtx_);
+    last_interval_ = std::move(interval);
+}
+
+
+std::vector<SchedSampler::ThreadSched> SchedSampler::LastInterval() const
+{
+    std::lock_guard<std::mutex> lck (mtx_);
+    return last_interval_;
+}
+
+
+bool SchedSampler::LastInterval(pid_t tid, ThreadSched& sched) const
+{
+    std::lock_guard<std::mutex> lck (mtx_);
+    for (const ThreadSched& entry : last_interval_) {
+        if (tid == entry.tid) {
+            sched = entry;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void SchedSampler::Report() const
+{
+    for (const ThreadSched& sched : LastInterval()) {
+        SYNC_LOG("sched {} ({}) : run {} us, runqueue wait {} us ({} us per slice), switches {} voluntary {} involuntary, migrations {}",
+            sched.name, sched.tid, sched.run_ns / 1000, sched.wait_ns / 1000, static_cast<uint64_t>(sched.WaitPerSliceNs() / 1000),
+            sched.voluntary_switches, sched.involuntary_switches, sched.migrations);
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "LinuxThread.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+// run queue delay and switch counts of the threads of this process, from /proc/self/task/<tid>
+// - schedstat : time on cpu, time runnable but waiting for a cpu (run queue delay), timeslices
+// - sched (CONFIG_SCHED_DEBUG) : voluntary / involuntary switches and migrations,
+//   status is the fallback for the switch counts and migrations then read as -1
+// - the background thread samples every thread of the process (every LinuxThread included), each interval
+//   gives per thread deltas, readable through LastInterval() and optionally logged through SyncLog
+// - look a LinuxThread up with LinuxThread::Tid()
+
+class SchedSampler
+{
+
+public:
+
+    struct ThreadSched
+    {
+        pid_t tid;
+        std::string name;
+        uint64_t run_ns;
+        // runnable, waiting for a cpu
+        uint64_t wait_ns;
+        uint64_t timeslices;
+        int64_t voluntary_switches;
+        int64_t involuntary_switches;
+        // -1 without /proc/<tid>/sched
+        int64_t migrations;
+
+        // mean run queue delay per timeslice
+        double WaitPerSliceNs() const
+        {
+            return timeslices ? static_cast<double>(wait_ns) / timeslices : 0.0;
+        }
+    };
+
+    // cumulative counters of one thread, false once it has exited
+    static bool ReadThread(pid_t tid, ThreadSched& sched);
+
+    // cumulative counters of every thread of this process
+    static std::vector<ThreadSched> ReadAll();
+
+    // Delete the copy constructor
+    SchedSampler(const SchedSampler&) = delete;
+
+    // Delete the Assignment opeartor
+    SchedSampler& operator=(const SchedSampler&) = delete;
+
+    // starts sampling, report logs every interval
+    explicit SchedSampler(std::chrono::milliseconds interval = std::chrono::seconds(1), bool report = true);
+
+    ~SchedSampler();
+
+    // per thread deltas over the last completed interval, threads that exited during it are left out
+    std::vector<ThreadSched> LastInterval() const;
+
+    // deltas of one thread over the last completed interval, false when it was not sampled
+    bool LastInterval(pid_t tid, ThreadSched& sched) const;
+
+    // one SyncLog line per thread of the last interval
+    void Report() const;
+
+private:
+
+    void Sample();
+
+    const std::chrono::milliseconds interval_;
+    const bool report_;
+
+    // sampler thread only
+    pid_t self_{0};
+    std::map<pid_t, ThreadSched> previous_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    bool stopping_{false};
+    std::vector<ThreadSched> last_interval_;
+
+    std::unique_ptr<LinuxThread> thread_;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "CacheLine.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// bounded single producer / single consumer ring
+// - capacity is rounded up to a power of two
+// - head and tail live on their own cache lines, each side caches the other's index
+//   so the shared line is only touched when the cached view says full / empty
+
+template <typename T>
+class SpscRing
+{
+
+public:
+
+    explicit SpscRing(std::size_t capacity) :
+        mask_(RoundUpPow2(capacity) - 1),
+        slots_(new T[mask_ + 1])
+    {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // producer : slot to fill in place, nullptr when full
+    // - offset claims ahead of unpublished slots so a batch can be published at once
+    T* Claim(std::size_t offset = 0)
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed) + offset;
+        if (head - cached_tail_ > mask_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ > mask_) return nullptr;
+        }
+        return &slots_[head & mask_];
+    }
+
+    // producer : make count claimed slots visible to the consumer
+    void Publish(std::size_t count = 1)
+    {
+        head_.store(head_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // producer
+    bool TryPush(T item)
+    {
+        T* slot = Claim();
+        if (!slot) return false;
+        *slot = std::move(item);
+        Publish();
+        return true;
+    }
+
+    // consumer : number of published slots ready to read
+    std::size_t Available()
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (cached_head_ == tail) cached_head_ = head_.load(std::memory_order_acquire);
+        return cached_head_ - tail;
+    }
+
+    // consumer : offset is relative to the oldest unconsumed slot, offset < Available()
+    T& Peek(std::size_t offset)
+    {
+        return slots_[(tail_.load(std::memory_order_relaxed) + offset) & mask_];
+    }
+
+    // consumer : hand count slots back to the producer
+    void Consume(std::size_t count)
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // consumer
+    bool TryPop(T& item)
+    {
+        if (0 == Available()) return false;
+        item = std::move(Peek(0));
+        Consume(1);
+        return true;
+    }
+
+    // approximate depth, safe from any thread
+    std::size_t Size() const
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    std::size_t Capacity() const
+    {
+        return mask_ + 1;
+    }
+
+private:
+
+    static std::size_t RoundUpPow2(std::size_t value)
+    {
+        std::size_t pow2 = 1;
+        while (pow2 < value) pow2 <<= 1;
+        return pow2;
+    }
+
+    // producer side
+    alignas(kCacheLineSize) std::atomic<std::size_t> head_{0};
+    std::size_t cached_tail_{0};
+
+    // consumer side
+    alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0};
+    std::size_t cached_head_{0};
+
+    // read only after construction
+    alignas(kCacheLineSize) const std::size_t mask_;
+    std::unique_ptr<T[]> slots_;
+};
@@ -0,0 +1,79 @@
+#include "StatsRegistry.h"
+
+#include "SyncLog.h"
+
+
+namespace {
+
+std::atomic<std::size_t> next_shard{0};
+
+} // namespace
+
+
+std::size_t StatsRegistry::AssignShard()
+{
+    return next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+}
+
+
+Counter::Counter() :
+    shards_(new Shard[StatsRegistry::kShards])
+{
+}
+
+
+uint64_t Counter::Read() const
+{
+    uint64_t sum{0};
+    for (std::size_t idx = 0; idx < StatsRegistry::kShards; idx++) sum += shards_[idx].value.load(std::memory_order_relaxed);
+    return sum;
+}
+
+
+void Counter::Reset()
+{
+    for (std::size_t idx = 0; idx < StatsRegistry::kShards; idx++) shards_[idx].value.store(0, std::memory_order_relaxed);
+}
+
+
+StatsRegistry* StatsRegistry::GetRegistry()
+{
+    static StatsRegistry registry;
+    return &registry;
+}
+
+
+Counter& StatsRegistry::GetCounter(const std::string& name)
+{
+    std::lock_guard<std::mutex> lck (mtx_);
+    auto& counter = counters_[name];
+    if (!counter) counter = std::make_unique<Counter>();
+    return *counter;
+}
+
+
+Gauge& StatsRegistry::GetGauge(const std::string& name)
+{
+    std::lock_guard<std::mutex> lck (mtx_);
+    auto& gauge = gauges_[name];
+    if (!gauge) gauge = std::make_unique<Gauge>();
+    return *gauge;
+}
+
+
+StatsRegistry::Snapshot StatsRegistry::GetSnapshot() const
+{
+    Snapshot snapshot;
+    std::lock_guard<std::mutex> lck (mtx_);
+    for (auto& [name, counter] : counters_) snapshot.counters[name] = counter->Read();
+    for (auto& [name, gauge] : gauges_) snapshot.gauges[name] = gauge->Read();
+    return snapshot;
+}
+
+
+void StatsRegistry::Report() const
+{
+    Snapshot snapshot = GetSnapshot();
+    for (auto& [name, value] : snapshot.counters) SyncLog::GetLog()->Log("counter " + name + " = " + std::to_string(value));
+    for (auto& [name, value] : snapshot.gauges) SyncLog::GetLog()->Log("gauge " + name + " = " + std::to_string(value));
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "CacheLine.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// named counters and gauges for worker progress
+// - a counter holds one cache line per shard, a thread always adds to the shard it was assigned on first use
+//   so concurrent writers never share a line
+// - adds are relaxed and uncontended, shards are summed only when the counter is read
+// - threads beyond kShards share shards round robin, the sum stays correct but adds may contend
+// - a gauge is one process wide value on its own cache line, meant for values set now and then (thread
+//   count, configured depth), not for per thread contributions
+// - look a metric up once and keep the reference, lookup takes the registry mutex
+// static Counter& passes = StatsRegistry::GetRegistry()->GetCounter("worker.passes");
+// passes.Add();
+
+class Counter
+{
+
+public:
+
+    // Delete the copy constructor
+    Counter(const Counter&) = delete;
+
+    // Delete the Assignment opeartor
+    Counter& operator=(const Counter&) = delete;
+
+    Counter();
+
+    void Add(uint64_t value = 1);
+
+    // sum over all shards
+    uint64_t Read() const;
+
+    void Reset();
+
+private:
+
+    struct alignas(kCacheLineSize) Shard
+    {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::unique_ptr<Shard[]> shards_;
+};
+
+
+// one process wide value, the last Set() wins, Add() moves it up or down
+class Gauge
+{
+
+public:
+
+    // Delete the copy constructor
+    Gauge(const Gauge&) = delete;
+
+    // Delete the Assignment opeartor
+    Gauge& operator=(const Gauge&) = delete;
+
+    Gauge() = default;
+
+    void Set(int64_t value);
+
+    void Add(int64_t value);
+
+    int64_t Read() const;
+
+private:
+
+    alignas(kCacheLineSize) std::atomic<int64_t> value_{0};
+};
+
+
+class StatsRegistry
+{
+
+public:
+
+    struct Snapshot
+    {
+        std::map<std::string, uint64_t> counters;
+        std::map<std::string, int64_t> gauges;
+    };
+
+    static StatsRegistry* GetRegistry();
+
+    // created on first lookup, the reference stays valid for the life of the process
+    Counter& GetCounter(const std::string& name);
+
+    Gauge& GetGauge(const std::string& name);
+
+    // every metric summed at the time of the call, not an atomic cut across metrics
+    Snapshot GetSnapshot() const;
+
+    // one SyncLog line per metric
+    void Report() const;
+
+    // shard written by the calling thread
+    static std::size_t ShardIndex();
+
+    static constexpr std::size_t kShards = 64;
+
+private:
+
+    static std::size_t AssignShard();
+
+    StatsRegistry() = default;
+
+    mutable std::mutex mtx_;
+    std::map<std::string, std::unique_ptr<Counter>> counters_;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges_;
+};
+
+
+// hot path inline, the thread_local is constant initialized so there is no init guard
+inline std::size_t StatsRegistry::ShardIndex()
+{
+    thread_local std::size_t shard = kShards;
+    if (kShards == shard) shard = AssignShard();
+    return shard;
+}
+
+
+inline void Counter::Add(uint64_t value)
+{
+    shards_[StatsRegistry::ShardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+}
+
+
+inline void Gauge::Set(int64_t value)
+{
+    value_.store(value, std::memory_order_relaxed);
+}
+
+
+inline void Gauge::Add(int64_t value)
+{
+    value_.fetch_add(value, std::memory_order_relaxed);
+}
+
+
+inline int64_t Gauge::Read() const
+{
+    return value_.load(std::memory_order_relaxed);
+}
@@ -1,7 +1,46 @@
 #include "SyncLog.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <limits.h>
+#include <sys/uio.h>
+
 SyncLog *SyncLog::log_ = 0;
 
+namespace {
+
+// format table, entries are written once before the first record that uses them is published
+const char* formats[SyncLog::kMaxFormats];
+uint16_t format_count{0};
+std::mutex formats_mtx;
+
+// write all iovecs, resuming after partial writes
+void WriteAll(int fd, struct iovec* iov, int count)
+{
+    while (count > 0) {
+        ssize_t written = writev(fd, iov, count);
+        if (written < 0) {
+            if (EINTR == errno) continue;
+            return;
+        }
+        while (count > 0 && static_cast<size_t>(written) >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+}
+
+}
+
 SyncLog* SyncLog::GetLog()
 {
     if (!log_) log_ = new SyncLog;
@@ -10,12 +49,287 @@ SyncLog* SyncLog::GetLog()
 
 void SyncLog::Log(std::string msg)
 {
-    std::lock_guard<std::mutex> lck (log_mtx_);
+    if (async_.load(std::memory_order_acquire)) {
+
+        ThreadRing* thread_ring = LocalRing();
+        // pairs with StopAsync() : either it waits for this record or this thread sees async_ cleared
+        thread_ring->writing.store(true, std::memory_order_seq_cst);
+        if (async_.load(std::memory_order_seq_cst)) {
+            Record* record = thread_ring->ring.Claim();
+            if (record) {
+                size_t length = std::min(msg.size(), sizeof(record->data) - 1);
+                std::memcpy(record->data, msg.data(), length);
+                record->data[length++] = '\n';
+                record->format_id = 0;
+                record->length = static_cast<uint16_t>(length);
+                thread_ring->ring.Publish();
+            } else {
+                overflows_.fetch_add(1, std::memory_order_relaxed);
+            }
+            thread_ring->writing.store(false, std::memory_order_release);
+            return;
+        }
+        // async stopped meanwhile, take the mutex path
+        thread_ring->writing.store(false, std::memory_order_release);
+    }
+
+    std::lock_guard<PiMutex> lck (log_mtx_);
     std::cout << msg << std::endl;
 }
 
 
-SyncLog::SyncLog() 
+void SyncLog::StartAsync(std::size_t ring_slots, int fd)
+{
+    std::lock_guard<PiMutex> lck (log_mtx_);
+    if (async_.load()) return;
+
+    std::cout.flush();
+
+    ring_slots_ = ring_slots;
+    fd_ = fd;
+    if (!render_buf_) render_buf_.reset(new char[IOV_MAX * kRenderBytes]);
+    overflows_.store(0);
+    generation_.fetch_add(1);
+    draining_.store(true);
+    drainer_ = std::thread(&SyncLog::Drain, this);
+    async_.store(true, std::memory_order_release);
+}
+
+
+void SyncLog::StopAsync()
+{
+    std::lock_guard<PiMutex> lck (log_mtx_);
+    if (!async_.load()) return;
+
+    // new messages take the mutex path, the ones already past the check are published before the last drain
+    async_.store(false, std::memory_order_seq_cst);
+    {
+        std::lock_guard<std::mutex> rings_lck (rings_mtx_);
+        for (auto& thread_ring : rings_) {
+            while (thread_ring->writing.load(std::memory_order_acquire)) std::this_thread::yield();
+        }
+    }
+    draining_.store(false);
+    drainer_.join();
+
+    std::lock_guard<std::mutex> rings_lck (rings_mtx_);
+    rings_.clear();
+    rings_version_++;
+}
+
+
+uint16_t SyncLog::RegisterFormat(const char* fmt)
+{
+    std::lock_guard<std::mutex> lck (formats_mtx);
+    // id 0 is reserved for preformatted text, the last id marks a full table
+    if (format_count + 2u >= kMaxFormats) return kMaxFormats - 1;
+    formats[++format_count] = fmt;
+    return format_count;
+}
+
+
+void SyncLog::LogRendered(const Record& record)
+{
+    char line[kRenderBytes];
+    std::size_t length = Render(record, line, sizeof(line));
+
+    std::lock_guard<PiMutex> lck (log_mtx_);
+    std::cout.write(line, length).flush();
+}
+
+
+std::size_t SyncLog::Render(const Record& record, char* out, std::size_t capacity)
+{
+    if (0 == record.format_id) {
+        std::size_t length = std::min<std::size_t>(record.length, capacity);
+        std::memcpy(out, record.data, length);
+        return length;
+    }
+
+    const char* fmt = (record.format_id < kMaxFormats - 1) ? formats[record.format_id] : "<SyncLog format table full>";
+    const char* arg = record.data;
+    const char* arg_end = record.data + record.length;
+
+    // keep room for the newline
+    std::size_t limit = capacity - 1;
+    std::size_t length = 0;
+
+    while (*fmt && length < limit) {
+        if ('{' == fmt[0] && '}' == fmt[1] && arg < arg_end) {
+            length += RenderArg(arg, arg_end, out + length, limit - length);
+            fmt += 2;
+            continue;
+        }
+        out[length++] = *fmt++;
+    }
+    out[length++] = '\n';
+    return length;
+}
+
+
+std::size_t SyncLog::RenderArg(const char*& arg, const char* arg_end, char* out, std::size_t capacity)
+{
+    // snprintf needs one byte past capacity for its terminator, Render() reserved it for the newline
+    auto scalar = [&arg](auto value) {
+        std::memcpy(&value, arg, sizeof(value));
+        arg += sizeof(value);
+        return value;
+    };
+
+    int written = 0;
+    switch (static_cast<ArgType>(*arg++)) {
+        case kArgInt:
+            written = std::snprintf(out, capacity + 1, "%" PRId64, scalar(int64_t{}));
+            break;
+        case kArgUint:
+            written = std::snprintf(out, capacity + 1, "%" PRIu64, scalar(uint64_t{}));
+            break;
+        case kArgDouble:
+            written = std::snprintf(out, capacity + 1, "%g", scalar(double{}));
+            break;
+        case kArgBool:
+            written = std::snprintf(out, capacity + 1, "%s", scalar(uint8_t{}) ? "true" : "false");
+            break;
+        case kArgPointer:
+            written = std::snprintf(out, capacity + 1, "0x%" PRIxPTR, scalar(uintptr_t{}));
+            break;
+        case kArgString: {
+            std::size_t length = static_cast<uint8_t>(*arg++);
+            written = static_cast<int>(std::min(length, capacity));
+            std::memcpy(out, arg, written);
+            arg += length;
+            break;
+        }
+        default:
+            arg = arg_end;
+            break;
+    }
+    return std::min<std::size_t>(std::max(written, 0), capacity);
+}
+
+
+void SyncLog::PutString(Encoder& encoder, std::string_view value)
 {
+    if (encoder.end - encoder.pos < 2) {
+        encoder.end = encoder.pos;
+        return;
+    }
+    std::size_t length = std::min<std::size_t>({value.size(), 255, static_cast<std::size_t>(encoder.end - encoder.pos - 2)});
+    *encoder.pos++ = static_cast<char>(kArgString);
+    *encoder.pos++ = static_cast<char>(length);
+    std::memcpy(encoder.pos, value.data(), length);
+    encoder.pos += length;
 }
 
+
+uint64_t SyncLog::Overflows() const
+{
+    return overflows_.load(std::memory_order_relaxed);
+}
+
+
+SyncLog::ThreadRing* SyncLog::LocalRing()
+{
+    // marks the ring retired on thread exit
+    static thread_local struct Retire {
+        ~Retire() { if (ring) ring->retired.store(true, std::memory_order_release); }
+        std::shared_ptr<ThreadRing> ring;
+    } retire;
+
+    uint64_t generation = generation_.load(std::memory_order_relaxed);
+    if (!retire.ring || retire.ring->generation != generation) {
+        // first message from this thread in this async session
+        if (retire.ring) retire.ring->retired.store(true, std::memory_order_release);
+        retire.ring = std::make_shared<ThreadRing>(ring_slots_, generation);
+        std::lock_guard<std::mutex> lck (rings_mtx_);
+        rings_.push_back(retire.ring);
+        rings_version_++;
+    }
+    return retire.ring.get();
+}
+
+
+void SyncLog::Drain()
+{
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    uint64_t version = ~uint64_t{0};
+    int idle_passes = 0;
+
+    while (draining_.load(std::memory_order_acquire)) {
+
+        {
+            std::lock_guard<std::mutex> lck (rings_mtx_);
+            if (version != rings_version_) {
+                // drop retired rings that have been fully drained
+                rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<ThreadRing>& ring) {
+                    return ring->retired.load(std::memory_order_acquire) && 0 == ring->ring.Size();
+                }), rings_.end());
+                rings = rings_;
+                version = ++rings_version_;
+            }
+        }
+
+        if (DrainOnce(rings)) {
+            idle_passes = 0;
+            continue;
+        }
+
+        // nothing to write, back off without ever blocking the producers
+        if (++idle_passes < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            // periodically rescan so retired rings get released
+            version = ~uint64_t{0};
+        }
+    }
+
+    std::lock_guard<std::mutex> lck (rings_mtx_);
+    rings = rings_;
+    while (DrainOnce(rings)) {}
+}
+
+
+bool SyncLog::DrainOnce(std::vector<std::shared_ptr<ThreadRing>>& rings)
+{
+    struct iovec iov[IOV_MAX];
+    std::size_t consumed[IOV_MAX];
+    int iov_count = 0;
+    std::size_t ring_count = std::min<std::size_t>(rings.size(), IOV_MAX);
+
+    // gather one batch across the rings, then give the slots back after the write
+    // - start from a rotating ring so one busy thread cannot starve the rest
+    std::size_t first = rings.empty() ? 0 : drain_cursor_++ % rings.size();
+    for (std::size_t ring_idx = 0; ring_idx < ring_count; ring_idx++) {
+        auto& thread_ring = rings[(first + ring_idx) % rings.size()];
+        std::size_t available = std::min<std::size_t>(thread_ring->ring.Available(), IOV_MAX - iov_count);
+        for (std::size_t idx = 0; idx < available; idx++) {
+            Record& record = thread_ring->ring.Peek(idx);
+            if (0 == record.format_id) {
+                iov[iov_count].iov_base = record.data;
+                iov[iov_count].iov_len = record.length;
+            } else {
+                // typed records are formatted here, off the logging threads
+                char* line = render_buf_.get() + iov_count * kRenderBytes;
+                iov[iov_count].iov_base = line;
+                iov[iov_count].iov_len = Render(record, line, kRenderBytes);
+            }
+            iov_count++;
+        }
+        consumed[ring_idx] = available;
+    }
+
+    if (0 == iov_count) return false;
+
+    WriteAll(fd_, iov, iov_count);
+
+    for (std::size_t ring_idx = 0; ring_idx < ring_count; ring_idx++) {
+        if (consumed[ring_idx]) rings[(first + ring_idx) % rings.size()]->ring.Consume(consumed[ring_idx]);
+    }
+    return true;
+}
+
+
+SyncLog::SyncLog() 
+{
+}
@@ -1,8 +1,32 @@
 #pragma once
 
+#include "PiMutex.h"
+#include "SpscRing.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+// typed log call with deferred formatting
+// - fmt must be a string literal, each "{}" is replaced by the next argument
+// - the format is registered once per call site, the hot path only copies the raw arguments
+//   into a fixed size binary record (no heap allocation, no formatting)
+// - the record is rendered to text by the async drainer, or inline on the mutex path
+// SYNC_LOG("thread {}, cores id = {}", name, sched_getcpu());
+#define SYNC_LOG(fmt, ...) \
+    do { \
+        static const uint16_t sync_log_format_id = SyncLog::RegisterFormat(fmt); \
+        SyncLog::GetLog()->LogFormat(sync_log_format_id, ##__VA_ARGS__); \
+    } while (0)
 
 class SyncLog
 {
@@ -13,10 +37,181 @@ public:
 
     void Log(std::string msg);
 
+    // binary record path behind SYNC_LOG()
+    template <typename... Args>
+    void LogFormat(uint16_t format_id, const Args&... args);
+
+    // format string table, ids are stable for the life of the process
+    static uint16_t RegisterFormat(const char* fmt);
+
+    // async mode : each logging thread appends to its own lock-free ring of ring_slots records,
+    // a single drainer thread batches the rings into writev() calls on fd
+    // - memory is bounded to ring_slots * kRecordBytes per logging thread
+    // - messages longer than a record are truncated, a full ring drops the message and counts an overflow
+    // - ordering is preserved per thread, not across threads
+    void StartAsync(std::size_t ring_slots = 1024, int fd = STDOUT_FILENO);
+
+    // drain outstanding records, stop the drainer and return to the mutex path
+    void StopAsync();
+
+    // messages dropped on a full ring since the last StartAsync()
+    uint64_t Overflows() const;
+
+    static constexpr std::size_t kRecordBytes = 256;
+    static constexpr std::size_t kMaxFormats = 1024;
+    // longest rendered line, typed records expand when formatted
+    static constexpr std::size_t kRenderBytes = 512;
+
 private:
 
-    std::mutex log_mtx_;
+    // format_id 0 : preformatted text, otherwise data holds the encoded arguments
+    struct Record
+    {
+        uint16_t format_id;
+        uint16_t length;
+        char data[kRecordBytes - 2 * sizeof(uint16_t)];
+    };
+
+    enum ArgType : uint8_t {
+        kArgInt,
+        kArgUint,
+        kArgDouble,
+        kArgBool,
+        kArgPointer,
+        kArgString
+    };
+
+    // write cursor into a record, end collapses onto pos once an argument does not fit
+    struct Encoder
+    {
+        char* pos;
+        char* end;
+    };
+
+    template <typename T>
+    static void PutScalar(Encoder& encoder, ArgType type, T value);
+    static void PutString(Encoder& encoder, std::string_view value);
+    template <typename T>
+    static void Put(Encoder& encoder, const T& value);
+    template <typename... Args>
+    static void Encode(Record& record, uint16_t format_id, const Args&... args);
+
+    // render a record as one line of text including the trailing newline, returns the length
+    static std::size_t Render(const Record& record, char* out, std::size_t capacity);
+    static std::size_t RenderArg(const char*& arg, const char* arg_end, char* out, std::size_t capacity);
+    void LogRendered(const Record& record);
+
+    struct ThreadRing
+    {
+        ThreadRing(std::size_t slots, uint64_t generation) : ring(slots), generation(generation) {}
+
+        SpscRing<Record> ring;
+        const uint64_t generation;
+        // set when the owning thread exits, the drainer releases the ring once it is empty
+        std::atomic<bool> retired{false};
+        // owner is between its async check and Publish(), StopAsync() waits for it to clear
+        std::atomic<bool> writing{false};
+    };
+
+    ThreadRing* LocalRing();
+    void Drain();
+    bool DrainOnce(std::vector<std::shared_ptr<ThreadRing>>& rings);
+
+    // realtime threads log too, see PiMutex
+    PiMutex log_mtx_;
     static SyncLog* log_;
 
+    // async state
+    std::atomic<bool> async_{false};
+    std::atomic<bool> draining_{false};
+    std::atomic<uint64_t> overflows_{0};
+    std::atomic<uint64_t> generation_{0};
+    std::size_t ring_slots_{0};
+    int fd_{STDOUT_FILENO};
+    std::thread drainer_;
+    std::size_t drain_cursor_{0};
+    std::unique_ptr<char[]> render_buf_;
+
+    // ring registration, only taken when a thread logs for the first time
+    std::mutex rings_mtx_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+    uint64_t rings_version_{0};
+
     SyncLog();
 };
+
+
+template <typename T>
+void SyncLog::PutScalar(Encoder& encoder, ArgType type, T value)
+{
+    if (encoder.end - encoder.pos < static_cast<std::ptrdiff_t>(1 + sizeof(T))) {
+        encoder.end = encoder.pos;
+        return;
+    }
+    *encoder.pos++ = static_cast<char>(type);
+    std::memcpy(encoder.pos, &value, sizeof(T));
+    encoder.pos += sizeof(T);
+}
+
+
+template <typename T>
+void SyncLog::Put(Encoder& encoder, const T& value)
+{
+    if constexpr (std::is_same_v<T, bool>) {
+        PutScalar(encoder, kArgBool, static_cast<uint8_t>(value));
+    } else if constexpr (std::is_same_v<T, char>) {
+        PutString(encoder, std::string_view(&value, 1));
+    } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+        if constexpr (std::is_signed_v<T> || std::is_enum_v<T>) {
+            PutScalar(encoder, kArgInt, static_cast<int64_t>(value));
+        } else {
+            PutScalar(encoder, kArgUint, static_cast<uint64_t>(value));
+        }
+    } else if constexpr (std::is_floating_point_v<T>) {
+        PutScalar(encoder, kArgDouble, static_cast<double>(value));
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        PutString(encoder, std::string_view(value));
+    } else if constexpr (std::is_pointer_v<T>) {
+        PutScalar(encoder, kArgPointer, reinterpret_cast<uintptr_t>(value));
+    } else {
+        static_assert(std::is_void_v<T>, "SYNC_LOG argument type not supported");
+    }
+}
+
+
+template <typename... Args>
+void SyncLog::Encode(Record& record, uint16_t format_id, const Args&... args)
+{
+    Encoder encoder{record.data, record.data + sizeof(record.data)};
+    (Put(encoder, args), ...);
+    record.format_id = format_id;
+    record.length = static_cast<uint16_t>(encoder.pos - record.data);
+}
+
+
+template <typename... Args>
+void SyncLog::LogFormat(uint16_t format_id, const Args&... args)
+{
+    if (async_.load(std::memory_order_acquire)) {
+
+        ThreadRing* thread_ring = LocalRing();
+        // pairs with StopAsync() : either it waits for this record or this thread sees async_ cleared
+        thread_ring->writing.store(true, std::memory_order_seq_cst);
+        if (async_.load(std::memory_order_seq_cst)) {
+            Record* record = thread_ring->ring.Claim();
+            if (record) {
+                Encode(*record, format_id, args...);
+                thread_ring->ring.Publish();
+            } else {
+                overflows_.fetch_add(1, std::memory_order_relaxed);
+            }
+            thread_ring->writing.store(false, std::memory_order_release);
+            return;
+        }
+        thread_ring->writing.store(false, std::memory_order_release);
+    }
+
+    Record record;
+    Encode(record, format_id, args...);
+    LogRendered(record);
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+// C++20 : build users of this header with -std=c++20
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+// lazily started coroutine returning T
+// - the body starts when the task is awaited, completion resumes the awaiting coroutine (symmetric transfer)
+// - the Task owns the coroutine frame
+// - top level tasks are started with CoroScheduler::Spawn()
+
+template <typename T = void>
+class Task;
+
+
+class TaskPromiseBase
+{
+
+public:
+
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept
+        {
+            return false;
+        }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            return handle.promise().continuation_;
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception()
+    {
+        error_ = std::current_exception();
+    }
+
+    void SetContinuation(std::coroutine_handle<> continuation)
+    {
+        continuation_ = continuation;
+    }
+
+protected:
+
+    void Rethrow()
+    {
+        if (error_) std::rethrow_exception(error_);
+    }
+
+    std::coroutine_handle<> continuation_{std::noop_coroutine()};
+    std::exception_ptr error_;
+};
+
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase
+{
+
+public:
+
+    Task<T> get_return_object();
+
+    void return_value(T value)
+    {
+        value_.emplace(std::move(value));
+    }
+
+    T Result()
+    {
+        Rethrow();
+        return std::move(*value_);
+    }
+
+private:
+
+    std::optional<T> value_;
+};
+
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase
+{
+
+public:
+
+    Task<void> get_return_object();
+
+    void return_void() {}
+
+    void Result()
+    {
+        Rethrow();
+    }
+};
+
+
+template <typename T>
+class Task
+{
+
+public:
+
+    using promise_type = TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) :
+        handle_(handle)
+    {
+    }
+
+    // Delete the copy constructor
+    Task(const Task&) = delete;
+
+    // Delete the Assignment opeartor
+    Task& operator=(const Task&) = delete;
+
+    Task(Task&& obj) noexcept :
+        handle_(std::exchange(obj.handle_, {}))
+    {
+    }
+
+    Task& operator=(Task&& obj) noexcept
+    {
+        if (handle_) handle_.destroy();
+        handle_ = std::exchange(obj.handle_, {});
+        return *this;
+    }
+
+    ~Task()
+    {
+        if (handle_) handle_.destroy();
+    }
+
+    // awaitable
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle_.promise().SetContinuation(awaiting);
+        return handle_;
+    }
+
+    T await_resume()
+    {
+        return handle_.promise().Result();
+    }
+
+private:
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
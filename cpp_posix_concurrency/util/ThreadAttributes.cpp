@@ -0,0 +1,178 @@
+#include "ThreadAttributes.h"
+
+
+ThreadAttributes& ThreadAttributes::Policy(int policy)
+{
+    policy_ = policy;
+    has_policy_ = true;
+    return *this;
+}
+
+
+ThreadAttributes& ThreadAttributes::Priority(int priority)
+{
+    priority_ = priority;
+    return *this;
+}
+
+
+ThreadAttributes& ThreadAttributes::Nice(int niceness)
+{
+    niceness_ = niceness;
+    has_nice_ = true;
+    return *this;
+}
+
+
+ThreadAttributes& ThreadAttributes::Affinity(unsigned int cpu)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    if (cpu < CPU_SETSIZE) CPU_SET(cpu, &cpus);
+    return Affinity(cpus);
+}
+
+
+ThreadAttributes& ThreadAttributes::Affinity(const cpu_set_t& cpus)
+{
+    cpus_ = cpus;
+    // empty set leaves the thread unpinned
+    has_affinity_ = CPU_COUNT(&cpus) > 0;
+    return *this;
+}
+
+
+ThreadAttributes& ThreadAttributes::Deadline(uint64_t runtime_ns, uint64_t deadline_ns, uint64_t period_ns)
+{
+    deadline_ = {runtime_ns, deadline_ns, period_ns};
+    has_deadline_ = true;
+    return *this;
+}
+
+
+ThreadAttributes& ThreadAttributes::RealTime(std::size_t prefault_stack_bytes)
+{
+    prefault_stack_bytes_ = prefault_stack_bytes;
+    realtime_ = true;
+    return *this;
+}
+
+
+ThreadAttributes& ThreadAttributes::PerfCounters(bool enable)
+{
+    perf_counters_ = enable;
+    return *this;
+}
+
+
+ThreadAttributes& ThreadAttributes::StackSize(std::size_t bytes)
+{
+    stack_size_ = bytes;
+    return *this;
+}
+
+
+ThreadAttributes& ThreadAttributes::GuardSize(std::size_t bytes)
+{
+    guard_size_ = bytes;
+    return *this;
+}
+
+
+int ThreadAttributes::Apply(pthread_attr_t* attr) const
+{
+    int rc = 0;
+
+    if (ExplicitSched()) {
+        /* For processes scheduled under one of the normal scheduling policies (SCHED_OTHER, SCHED_IDLE, SCHED_BATCH),
+           sched_priority is not used in scheduling decisions (it must be specified as 0).
+        */
+        sched_param scheduler_params{};
+        bool realtime = (SCHED_FIFO == policy_ || SCHED_RR == policy_);
+        scheduler_params.sched_priority = realtime ? priority_ : 0;
+
+        if ((rc = pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED))) return rc;
+        if ((rc = pthread_attr_setschedpolicy(attr, policy_))) return rc;
+        if ((rc = pthread_attr_setschedparam(attr, &scheduler_params))) return rc;
+    }
+
+    if (has_affinity_ && (rc = pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), &cpus_))) return rc;
+
+    if (stack_size_ && (rc = pthread_attr_setstacksize(attr, stack_size_))) return rc;
+
+    if (guard_size_ && (rc = pthread_attr_setguardsize(attr, guard_size_))) return rc;
+
+    return rc;
+}
+
+
+bool ThreadAttributes::ExplicitSched() const
+{
+    return has_policy_ && !HasThreadPolicy() && !has_deadline_;
+}
+
+
+bool ThreadAttributes::HasThreadPolicy() const
+{
+    return has_policy_ && !has_deadline_ && (SCHED_BATCH == policy_ || SCHED_IDLE == policy_);
+}
+
+
+int ThreadAttributes::ThreadPolicy() const
+{
+    return policy_;
+}
+
+
+bool ThreadAttributes::HasDeadline() const
+{
+    return has_deadline_;
+}
+
+
+const ThreadAttributes::DeadlineParams& ThreadAttributes::DeadlineParameters() const
+{
+    return deadline_;
+}
+
+
+bool ThreadAttributes::IsRealTime() const
+{
+    return realtime_;
+}
+
+
+std::size_t ThreadAttributes::PrefaultStackBytes() const
+{
+    return prefault_stack_bytes_;
+}
+
+
+bool ThreadAttributes::HasPerfCounters() const
+{
+    return perf_counters_;
+}
+
+
+bool ThreadAttributes::HasNice() const
+{
+    return has_nice_;
+}
+
+
+int ThreadAttributes::Niceness() const
+{
+    return niceness_;
+}
+
+
+bool ThreadAttributes::HasAffinity() const
+{
+    return has_affinity_;
+}
+
+
+const cpu_set_t& ThreadAttributes::Cpus() const
+{
+    return cpus_;
+}
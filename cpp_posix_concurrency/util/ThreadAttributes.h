@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <pthread.h>
+#include <sched.h>
+
+// thread creation attributes applied through pthread_attr_t before the thread exists
+// - policy, priority, affinity, stack and guard size take effect with PTHREAD_EXPLICIT_SCHED,
+//   so the first instruction of the thread already runs on the requested cpus under the requested policy
+// - niceness has no pthread_attr_t field and glibc only accepts SCHED_OTHER / SCHED_FIFO / SCHED_RR in
+//   pthread_attr_setschedpolicy(), LinuxThread applies niceness and SCHED_BATCH / SCHED_IDLE on the new thread
+//   before the user function
+// - SCHED_DEADLINE has no pthread_attr_t support either, the new thread calls sched_setattr() on itself
+//   before the user function. The kernel refuses deadline threads with a restricted affinity mask,
+//   do not combine Deadline() with Affinity()
+//
+// ThreadAttributes().Policy(SCHED_FIFO).Priority(10).Affinity(2).StackSize(256 * 1024)
+
+class ThreadAttributes
+{
+
+public:
+
+    // SCHED_DEADLINE reservation, runtime <= deadline <= period
+    struct DeadlineParams
+    {
+        uint64_t runtime_ns;
+        uint64_t deadline_ns;
+        uint64_t period_ns;
+    };
+
+    ThreadAttributes& Policy(int policy);
+
+    // sched_priority, realtime policies only
+    ThreadAttributes& Priority(int priority);
+
+    // CFS policies only
+    ThreadAttributes& Nice(int niceness);
+
+    ThreadAttributes& Affinity(unsigned int cpu);
+    ThreadAttributes& Affinity(const cpu_set_t& cpus);
+
+    // SCHED_DEADLINE, the thread is sent SIGXCPU (counted by LinuxThread) when a job overruns its runtime
+    // - the first deadline thread installs a process wide SIGXCPU handler. A handler the application had
+    //   installed before keeps running for signals taken outside deadline threads, SIG_DFL does not
+    //   (e.g. RLIMIT_CPU no longer terminates the process)
+    // - the count is best effort, see LinuxThread::DeadlineOverruns()
+    ThreadAttributes& Deadline(uint64_t runtime_ns, uint64_t deadline_ns, uint64_t period_ns);
+
+    // real-time thread : prefault prefault_stack_bytes of stack before the user function and mark the thread
+    // for RealTimeMemory's allocation detector
+    ThreadAttributes& RealTime(std::size_t prefault_stack_bytes);
+
+    // open per thread perf_event_open counters on the new thread before the user function,
+    // read them with LinuxThread::ThreadInfo()
+    ThreadAttributes& PerfCounters(bool enable = true);
+
+    ThreadAttributes& StackSize(std::size_t bytes);
+
+    ThreadAttributes& GuardSize(std::size_t bytes);
+
+    // fill an initialized pthread_attr_t, returns 0 or the failing pthread_attr_* error
+    int Apply(pthread_attr_t* attr) const;
+
+    // true when Apply() requests PTHREAD_EXPLICIT_SCHED
+    bool ExplicitSched() const;
+
+    // SCHED_BATCH / SCHED_IDLE, set by the new thread itself
+    bool HasThreadPolicy() const;
+    int ThreadPolicy() const;
+
+    bool HasDeadline() const;
+    const DeadlineParams& DeadlineParameters() const;
+
+    bool IsRealTime() const;
+    std::size_t PrefaultStackBytes() const;
+
+    bool HasPerfCounters() const;
+
+    bool HasNice() const;
+    int Niceness() const;
+
+    bool HasAffinity() const;
+    const cpu_set_t& Cpus() const;
+
+private:
+
+    int policy_{SCHED_OTHER};
+    int priority_{0};
+    int niceness_{0};
+    cpu_set_t cpus_{};
+    DeadlineParams deadline_{};
+    std::size_t stack_size_{0};
+    std::size_t guard_size_{0};
+    std::size_t prefault_stack_bytes_{0};
+
+    bool has_policy_{false};
+    bool has_nice_{false};
+    bool has_deadline_{false};
+    bool realtime_{false};
+    bool perf_counters_{false};
+    bool has_affinity_{false};
+};
@@ -0,0 +1,256 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace {
+
+// worker identity of the calling thread
+thread_local ThreadPool* current_pool{nullptr};
+thread_local int current_worker{-1};
+
+uint64_t xorshift(uint64_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+std::vector<ThreadPool::WorkerConfig> default_workers(unsigned int num_workers)
+{
+    // one read of the affinity mask and cgroup files, worker idx goes to the (idx modulo count)th cpu
+    cpu_set_t effective = CpuTopology::EffectiveCpus();
+    std::vector<unsigned int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &effective)) cpus.push_back(cpu);
+    }
+
+    std::vector<ThreadPool::WorkerConfig> workers;
+    for (unsigned int idx = 0; idx < num_workers; idx++) {
+        unsigned int cpu = cpus.empty() ? idx : cpus[idx % cpus.size()];
+        workers.push_back({"pool_" + std::to_string(idx), SCHED_OTHER, 0, cpu});
+    }
+    return workers;
+}
+
+}
+
+
+ThreadPool::ThreadPool(unsigned int num_workers) :
+    ThreadPool(default_workers(num_workers ? num_workers : 1))
+{
+}
+
+
+ThreadPool::ThreadPool(std::vector<WorkerConfig> workers)
+{
+    uint64_t seed = 0x9e3779b97f4a7c15ull;
+    for (auto& config : workers) {
+        workers_.emplace_back(new Worker(config, seed));
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    }
+
+    // deques are in place before any worker can steal
+    threads_.reserve(workers_.size());
+    for (unsigned int idx = 0; idx < workers_.size(); idx++) {
+        const WorkerConfig& config = workers_[idx]->config;
+        bool realtime = (SCHED_FIFO == config.policy || SCHED_RR == config.policy);
+
+        // scheduling and placement are in effect before the worker runs its first instruction
+        ThreadAttributes attributes = ThreadAttributes().Policy(config.policy).Affinity(config.affinity);
+        if (realtime) {
+            attributes.Priority(config.priority);
+        } else {
+            attributes.Nice(config.priority);
+        }
+        threads_.emplace_back([this, idx]() { WorkerLoop(idx); }, attributes);
+    }
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    // drain, then stop
+    while (outstanding_.load(std::memory_order_acquire) > 0) {
+        if (!TryRunOne()) std::this_thread::yield();
+    }
+
+    {
+        std::lock_guard<std::mutex> lck (sleep_mtx_);
+        stopping_.store(true);
+        wake_epoch_++;
+    }
+    sleep_cv_.notify_all();
+
+    for (auto& thread : threads_) thread.Join();
+}
+
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+    Task* pool_task = new Task{std::move(task)};
+    outstanding_.fetch_add(1, std::memory_order_relaxed);
+
+    if (this == current_pool && current_worker >= 0) {
+        workers_[current_worker]->deque.Push(pool_task);
+    } else {
+        std::lock_guard<std::mutex> lck (inject_mtx_);
+        inject_.push_back(pool_task);
+        inject_size_.store(inject_.size(), std::memory_order_relaxed);
+    }
+
+    // pairs with the fence in the parking path, either the sleeper sees the task or we see the sleeper
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) > 0) Wake();
+}
+
+
+void ThreadPool::Execute(std::function<void()> task)
+{
+    Submit(std::move(task));
+}
+
+
+bool ThreadPool::TryRunOne()
+{
+    thread_local uint64_t rng_state = 0x2545f4914f6cdd1dull ^ reinterpret_cast<uintptr_t>(&rng_state);
+
+    Task* task = (this == current_pool) ? FindWork(current_worker, rng_state) : FindWork(-1, rng_state);
+    if (!task) return false;
+    Run(task);
+    return true;
+}
+
+
+unsigned int ThreadPool::WorkerCount() const
+{
+    return workers_.size();
+}
+
+
+void ThreadPool::WorkerLoop(unsigned int idx)
+{
+    Worker& worker = *workers_[idx];
+
+    current_pool = this;
+    current_worker = idx;
+
+    while (true) {
+
+        Task* task = FindWork(idx, worker.rng_state);
+
+        // brief spin before parking, fine grained fork / join refills quickly
+        for (int spin = 0; !task && spin < 64; spin++) {
+            if (stopping_.load(std::memory_order_relaxed)) break;
+            std::this_thread::yield();
+            task = FindWork(idx, worker.rng_state);
+        }
+
+        if (task) {
+            Run(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lck (sleep_mtx_);
+        if (stopping_.load()) break;
+        uint64_t epoch = wake_epoch_;
+        sleepers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // recheck after announcing, a submit racing the announcement is found here
+        task = FindWork(idx, worker.rng_state);
+        if (!task) sleep_cv_.wait(lck, [this, epoch] { return wake_epoch_ != epoch; });
+
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        lck.unlock();
+
+        if (task) Run(task);
+    }
+
+    current_pool = nullptr;
+    current_worker = -1;
+}
+
+
+ThreadPool::Task* ThreadPool::FindWork(int idx, uint64_t& rng_state)
+{
+    Task* task = nullptr;
+
+    if (idx >= 0 && workers_[idx]->deque.Pop(task)) return task;
+
+    if (inject_size_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lck (inject_mtx_);
+        if (!inject_.empty()) {
+            task = inject_.front();
+            inject_.pop_front();
+            inject_size_.store(inject_.size(), std::memory_order_relaxed);
+            return task;
+        }
+    }
+
+    return Steal(idx, rng_state);
+}
+
+
+ThreadPool::Task* ThreadPool::Steal(int thief_idx, uint64_t& rng_state)
+{
+    std::size_t num_workers = workers_.size();
+    std::size_t start = xorshift(rng_state) % num_workers;
+    Task* task = nullptr;
+
+    // random first victim, then sweep the rest once
+    for (std::size_t offset = 0; offset < num_workers; offset++) {
+        std::size_t victim = (start + offset) % num_workers;
+        if (static_cast<int>(victim) == thief_idx) continue;
+        if (workers_[victim]->deque.Steal(task)) return task;
+    }
+    return nullptr;
+}
+
+
+void ThreadPool::Wake()
+{
+    {
+        std::lock_guard<std::mutex> lck (sleep_mtx_);
+        wake_epoch_++;
+    }
+    sleep_cv_.notify_one();
+}
+
+
+void ThreadPool::Run(Task* task)
+{
+    task->func();
+    delete task;
+    outstanding_.fetch_sub(1, std::memory_order_release);
+}
+
+
+TaskGroup::TaskGroup(ThreadPool& pool) :
+    pool_(pool)
+{
+}
+
+
+TaskGroup::~TaskGroup()
+{
+    Wait();
+}
+
+
+void TaskGroup::Run(std::function<void()> task)
+{
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    pool_.Submit([this, task = std::move(task)]() {
+        task();
+        pending_.fetch_sub(1, std::memory_order_release);
+    });
+}
+
+
+void TaskGroup::Wait()
+{
+    while (pending_.load(std::memory_order_acquire) > 0) {
+        if (!pool_.TryRunOne()) std::this_thread::yield();
+    }
+}
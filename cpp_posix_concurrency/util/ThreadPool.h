@@ -0,0 +1,127 @@
+#pragma once
+
+#include "ChaseLevDeque.h"
+#include "CpuTopology.h"
+#include "Executor.h"
+#include "LinuxThread.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// work stealing executor on LinuxThread workers
+// - each worker owns a Chase-Lev deque, tasks submitted from a worker go to its own deque (LIFO for the owner)
+// - tasks submitted from other threads go to a shared injection queue
+// - idle workers steal from random victims, then park on a condition variable
+
+class ThreadPool : public Executor
+{
+
+public:
+
+    // per worker scheduling, applied through ThreadAttributes before the worker starts
+    // - CFS policies (SCHED_OTHER, SCHED_BATCH, SCHED_IDLE) : priority is the niceness
+    // - realtime policies (SCHED_FIFO, SCHED_RR) : priority is the sched_priority
+    struct WorkerConfig
+    {
+        std::string name;
+        int policy;
+        int priority;
+        unsigned int affinity;
+    };
+
+    // Delete the copy constructor
+    ThreadPool(const ThreadPool&) = delete;
+
+    // Delete the Assignment opeartor
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // SCHED_OTHER workers, worker idx pinned to CpuTopology::EffectiveCpu(idx)
+    explicit ThreadPool(unsigned int num_workers = CpuTopology::EffectiveConcurrency());
+
+    explicit ThreadPool(std::vector<WorkerConfig> workers);
+
+    // runs the tasks already queued, then joins the workers
+    ~ThreadPool();
+
+    void Submit(std::function<void()> task);
+
+    // Executor, same as Submit()
+    void Execute(std::function<void()> task) override;
+
+    // run one queued task on the calling thread, false when none was found
+    bool TryRunOne();
+
+    unsigned int WorkerCount() const;
+
+private:
+
+    struct Task
+    {
+        std::function<void()> func;
+    };
+
+    struct Worker
+    {
+        Worker(WorkerConfig config, uint64_t seed) : config(std::move(config)), rng_state(seed) {}
+
+        WorkerConfig config;
+        ChaseLevDeque<Task*> deque;
+        uint64_t rng_state;
+    };
+
+    void WorkerLoop(unsigned int idx);
+    Task* FindWork(int idx, uint64_t& rng_state);
+    Task* Steal(int thief_idx, uint64_t& rng_state);
+    void Wake();
+    void Run(Task* task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<LinuxThread> threads_;
+
+    // tasks submitted from outside the pool
+    std::mutex inject_mtx_;
+    std::deque<Task*> inject_;
+    std::atomic<std::size_t> inject_size_{0};
+
+    // parking
+    std::mutex sleep_mtx_;
+    std::condition_variable sleep_cv_;
+    std::atomic<int> sleepers_{0};
+    uint64_t wake_epoch_{0};
+    std::atomic<bool> stopping_{false};
+    std::atomic<std::size_t> outstanding_{0};
+};
+
+
+// fork / join scope on a ThreadPool, Wait() runs pool tasks instead of blocking
+class TaskGroup
+{
+
+public:
+
+    explicit TaskGroup(ThreadPool& pool);
+
+    // Delete the copy constructor
+    TaskGroup(const TaskGroup&) = delete;
+
+    // Delete the Assignment opeartor
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ~TaskGroup();
+
+    void Run(std::function<void()> task);
+
+    void Wait();
+
+private:
+
+    ThreadPool& pool_;
+    std::atomic<int> pending_{0};
+};
@@ -0,0 +1,297 @@
+#include "TimerWheel.h"
+
+#include "SyncLog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <utility>
+
+namespace {
+
+constexpr uint64_t kMaxTicks = (uint64_t{1} << 32) - 1;
+
+timespec to_timespec(std::chrono::nanoseconds duration)
+{
+    return {static_cast<time_t>(duration.count() / 1000000000), static_cast<long>(duration.count() % 1000000000)};
+}
+
+}
+
+
+TimerWheel::TimerWheel(Executor& executor, std::chrono::nanoseconds tick, Drive drive) :
+    executor_(executor),
+    tick_(tick.count() > 0 ? tick : std::chrono::milliseconds(1))
+{
+    for (auto& slot : root_) InitSlot(slot);
+    for (auto& level : levels_) {
+        for (auto& slot : level) InitSlot(slot);
+    }
+
+    if (Drive::MANUAL == drive) return;
+
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (timer_fd_ < 0) {
+        SyncLog::GetLog()->Log("timerfd_create() failure : " + std::string(std::strerror(errno)) + ", timers only advance through Expire()");
+        return;
+    }
+    timer_thread_.reset(new LinuxThread([this](std::string) { TimerLoop(); }, "timer_wheel"));
+}
+
+
+TimerWheel::~TimerWheel()
+{
+    if (timer_thread_) {
+        stopping_.store(true, std::memory_order_release);
+        {
+            // one shot in a nanosecond wakes the loop to see stopping_
+            std::lock_guard<std::mutex> lck (mtx_);
+            itimerspec spec{};
+            spec.it_value.tv_nsec = 1;
+            timerfd_settime(timer_fd_, 0, &spec, nullptr);
+        }
+        timer_thread_.reset();
+    }
+    if (timer_fd_ >= 0) close(timer_fd_);
+}
+
+
+TimerWheel::TimerId TimerWheel::Schedule(std::chrono::nanoseconds delay, std::function<void()> callback)
+{
+    uint64_t ticks = delay.count() <= 0 ? 1 : (delay.count() + tick_.count() - 1) / tick_.count();
+
+    std::lock_guard<std::mutex> lck (mtx_);
+    if (armed_) {
+        // ticks the timerfd already counted but the timer thread has not run yet, now_ lags by that much
+        auto behind = std::chrono::steady_clock::now() - next_due_;
+        if (behind.count() >= 0) ticks += behind / tick_ + 1;
+    }
+    if (ticks > kMaxTicks) ticks = kMaxTicks;
+
+    Node* node = Allocate();
+    // now_ is the next tick to run and may be due in less than a tick, so a one tick delay expires on the
+    // tick after it (never early, at most one tick late, the kernel adds a jiffy the same way)
+    node->expires = now_ + ticks;
+    node->callback = std::move(callback);
+    Insert(node);
+    if (0 == pending_++ && timer_fd_ >= 0 && !armed_) Arm(true);
+
+    return (static_cast<uint64_t>(node->generation) << 32) | node->index;
+}
+
+
+bool TimerWheel::Cancel(TimerId id)
+{
+    uint32_t index = static_cast<uint32_t>(id);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+
+    // captures are destroyed outside the lock
+    std::function<void()> callback;
+    {
+        std::lock_guard<std::mutex> lck (mtx_);
+        if (index >= nodes_.size()) return false;
+        Node* node = &nodes_[index];
+        if (!node->linked || node->generation != generation) return false;
+
+        Unlink(node);
+        callback = std::move(node->callback);
+        Release(node);
+        pending_--;
+    }
+    return true;
+}
+
+
+std::size_t TimerWheel::Expire(std::size_t ticks)
+{
+    std::vector<std::function<void()>> expired;
+    {
+        std::lock_guard<std::mutex> lck (mtx_);
+        for (std::size_t idx = 0; idx < ticks; idx++) {
+            if (0 == pending_) {
+                // nothing to cascade or run, skip the remaining ticks at once
+                now_ += ticks - idx;
+                next_due_ += (ticks - idx) * tick_;
+                break;
+            }
+            RunTick(expired);
+        }
+        if (0 == pending_ && armed_) Arm(false);
+    }
+
+    // one executor task per batch of callbacks
+    for (std::size_t first = 0; first < expired.size(); first += kDispatchBatch) {
+        std::size_t last = std::min(first + kDispatchBatch, expired.size());
+        if (0 == first && last == expired.size()) {
+            executor_.Execute([batch = std::move(expired)]() mutable {
+                for (auto& callback : batch) callback();
+            });
+            return last;
+        }
+
+        std::vector<std::function<void()>> batch(std::make_move_iterator(expired.begin() + first),
+            std::make_move_iterator(expired.begin() + last));
+        executor_.Execute([batch = std::move(batch)]() mutable {
+            for (auto& callback : batch) callback();
+        });
+    }
+    return expired.size();
+}
+
+
+std::size_t TimerWheel::Pending() const
+{
+    std::lock_guard<std::mutex> lck (mtx_);
+    return pending_;
+}
+
+
+std::chrono::nanoseconds TimerWheel::Tick() const
+{
+    return tick_;
+}
+
+
+void TimerWheel::InitSlot(Link& slot)
+{
+    slot.prev = &slot;
+    slot.next = &slot;
+}
+
+
+void TimerWheel::LinkBefore(Link& slot, Node* node)
+{
+    node->prev = slot.prev;
+    node->next = &slot;
+    slot.prev->next = node;
+    slot.prev = node;
+    node->linked = true;
+}
+
+
+void TimerWheel::Unlink(Node* node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->linked = false;
+}
+
+
+void TimerWheel::Insert(Node* node)
+{
+    uint64_t delta = node->expires - now_;
+
+    if (delta < kRootSize) {
+        LinkBefore(root_[node->expires & (kRootSize - 1)], node);
+        return;
+    }
+
+    for (unsigned int level = 0; level < kLevels; level++) {
+        unsigned int shift = kRootBits + level * kLevelBits;
+        if (level + 1 == kLevels || delta < (uint64_t{1} << (shift + kLevelBits))) {
+            LinkBefore(levels_[level][(node->expires >> shift) & (kLevelSize - 1)], node);
+            return;
+        }
+    }
+}
+
+
+void TimerWheel::Cascade(Link& slot)
+{
+    // detach the slot, then rehash every node relative to now_
+    Link* link = slot.next;
+    InitSlot(slot);
+    while (link != &slot) {
+        Node* node = static_cast<Node*>(link);
+        link = link->next;
+        Insert(node);
+    }
+}
+
+
+void TimerWheel::RunTick(std::vector<std::function<void()>>& expired)
+{
+    std::size_t index = now_ & (kRootSize - 1);
+
+    // root wrapped : pull the next slot of each level down, up the levels while they wrap too
+    if (0 == index) {
+        for (unsigned int level = 0; level < kLevels; level++) {
+            std::size_t level_index = (now_ >> (kRootBits + level * kLevelBits)) & (kLevelSize - 1);
+            Cascade(levels_[level][level_index]);
+            if (0 != level_index) break;
+        }
+    }
+
+    Link& slot = root_[index];
+    while (slot.next != &slot) {
+        Node* node = static_cast<Node*>(slot.next);
+        Unlink(node);
+        expired.push_back(std::move(node->callback));
+        Release(node);
+        pending_--;
+    }
+    now_++;
+    next_due_ += tick_;
+}
+
+
+TimerWheel::Node* TimerWheel::Allocate()
+{
+    if (!free_.empty()) {
+        Node* node = &nodes_[free_.back()];
+        free_.pop_back();
+        return node;
+    }
+
+    nodes_.emplace_back();
+    Node* node = &nodes_.back();
+    node->index = static_cast<uint32_t>(nodes_.size() - 1);
+    return node;
+}
+
+
+void TimerWheel::Release(Node* node)
+{
+    node->callback = nullptr;
+    // stale ids stop matching, 0 stays reserved
+    if (0 == ++node->generation) node->generation = 1;
+    free_.push_back(node->index);
+}
+
+
+void TimerWheel::Arm(bool periodic)
+{
+    itimerspec spec{};
+    // read before arming, the first expiry can only come later than this estimate
+    next_due_ = std::chrono::steady_clock::now() + tick_;
+    if (periodic) {
+        spec.it_value = to_timespec(tick_);
+        spec.it_interval = to_timespec(tick_);
+    }
+    if (0 != timerfd_settime(timer_fd_, 0, &spec, nullptr)) {
+        SyncLog::GetLog()->Log("timerfd_settime() failure : " + std::string(std::strerror(errno)));
+        return;
+    }
+    armed_ = periodic;
+}
+
+
+void TimerWheel::TimerLoop()
+{
+    while (!stopping_.load(std::memory_order_acquire)) {
+        // number of ticks since the last read, more than one when this thread was held up
+        uint64_t ticks{0};
+        ssize_t bytes = read(timer_fd_, &ticks, sizeof(ticks));
+        if (bytes != sizeof(ticks)) {
+            if (EINTR == errno) continue;
+            SyncLog::GetLog()->Log("timerfd read() failure : " + std::string(std::strerror(errno)));
+            return;
+        }
+        if (stopping_.load(std::memory_order_acquire)) return;
+        Expire(ticks);
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Executor.h"
+#include "LinuxThread.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// hashed hierarchical timer wheel, the cascading layout of the kernel's classic timer_list
+// (see modules/ubuntu_18_04/4_timers)
+// - time is counted in ticks, level 0 has 256 slots of one tick, levels 1..4 have 64 slots each covering
+//   the whole span of the level below, 2^32 ticks in total (longer delays are clamped)
+// - Schedule() and Cancel() are O(1) : hash the expiry into a slot, link / unlink an intrusive node
+// - each time level 0 wraps, the next slot of level 1 is cascaded down (recursively up the levels)
+// - one timerfd thread ticks the wheel while timers are pending and hands every tick's expired callbacks
+//   to the executor in batches of up to kDispatchBatch, so thousands of timeouts cost one thread
+// - callbacks run on the executor, never under the wheel's lock, they may Schedule() / Cancel()
+// - a timer never fires before its delay, its tick runs at most one tick after it (then the executor's
+//   own latency), pending timers are dropped on destruction
+//
+// TimerWheel wheel(pool, std::chrono::milliseconds(1));
+// TimerWheel::TimerId id = wheel.Schedule(std::chrono::seconds(30), [] { CloseIdleConnection(); });
+// wheel.Cancel(id);
+
+class TimerWheel
+{
+
+public:
+
+    // 0 is never a valid id
+    using TimerId = uint64_t;
+
+    // TIMERFD : ticked by the internal timerfd thread
+    // MANUAL : ticked only by Expire(), for simulations and benchmarks
+    enum class Drive {
+        TIMERFD,
+        MANUAL
+    };
+
+    static constexpr std::size_t kDispatchBatch = 256;
+
+    explicit TimerWheel(Executor& executor, std::chrono::nanoseconds tick = std::chrono::milliseconds(1),
+        Drive drive = Drive::TIMERFD);
+
+    // Delete the copy constructor
+    TimerWheel(const TimerWheel&) = delete;
+
+    // Delete the Assignment opeartor
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    ~TimerWheel();
+
+    // callback runs on the executor after delay, rounded up to whole ticks (at least one)
+    TimerId Schedule(std::chrono::nanoseconds delay, std::function<void()> callback);
+
+    // true when the timer was still pending, false once fired, cancelled or unknown
+    bool Cancel(TimerId id);
+
+    // advance ticks, dispatch what expired, returns the number of expired timers
+    std::size_t Expire(std::size_t ticks = 1);
+
+    std::size_t Pending() const;
+
+    std::chrono::nanoseconds Tick() const;
+
+private:
+
+    static constexpr unsigned int kRootBits = 8;
+    static constexpr unsigned int kLevelBits = 6;
+    static constexpr unsigned int kLevels = 4;
+    static constexpr std::size_t kRootSize = std::size_t{1} << kRootBits;
+    static constexpr std::size_t kLevelSize = std::size_t{1} << kLevelBits;
+
+    // circular doubly linked list, a slot is its sentinel
+    struct Link
+    {
+        Link* prev;
+        Link* next;
+    };
+
+    struct Node : Link
+    {
+        uint64_t expires{0};
+        uint32_t index{0};
+        uint32_t generation{1};
+        bool linked{false};
+        std::function<void()> callback;
+    };
+
+    static void InitSlot(Link& slot);
+    static void LinkBefore(Link& slot, Node* node);
+    static void Unlink(Node* node);
+
+    void Insert(Node* node);
+    void Cascade(Link& slot);
+    void RunTick(std::vector<std::function<void()>>& expired);
+    Node* Allocate();
+    void Release(Node* node);
+    void Arm(bool periodic);
+    void TimerLoop();
+
+    Executor& executor_;
+    const std::chrono::nanoseconds tick_;
+
+    mutable std::mutex mtx_;
+    uint64_t now_{0};
+    std::size_t pending_{0};
+    Link root_[kRootSize];
+    Link levels_[kLevels][kLevelSize];
+
+    // stable node storage indexed by TimerId, recycled through free_
+    std::deque<Node> nodes_;
+    std::vector<uint32_t> free_;
+
+    int timer_fd_{-1};
+    bool armed_{false};
+    // while armed : when the timerfd expiry for tick now_ is due
+    std::chrono::steady_clock::time_point next_due_;
+    std::atomic<bool> stopping_{false};
+    std::unique_ptr<LinuxThread> timer_thread_;
+};